@@ -26,6 +26,7 @@ public class GCExt : ModuleRules
                 "ModularGameplay",
                 "GameplayTags",
                 "GameFeatures",
+                "DeveloperSettings",
                 "GFCore",
             }
         );
@@ -35,6 +36,7 @@ public class GCExt : ModuleRules
             new string[]
             {
                 "NetCore",
+                "AssetRegistry",
             }
         );
 
@@ -2,13 +2,71 @@
 
 #include "GCExt.h"
 
+#include "Recipe/CharacterRecipeRegistry.h"
+#include "GCExtLogs.h"
+
+#include "Misc/CoreDelegates.h"
+
 IMPLEMENT_MODULE(FGCExtModule, GCExt)
 
 
 void FGCExtModule::StartupModule()
 {
+	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FGCExtModule::HandlePostEngineInit);
 }
 
 void FGCExtModule::ShutdownModule()
 {
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+
+	UnregisterNetworkVersionOverride();
+}
+
+
+void FGCExtModule::HandlePostEngineInit()
+{
+	GetMutableDefault<UCharacterRecipeRegistry>()->RebuildRegistry();
+
+	RegisterNetworkVersionOverride();
+}
+
+
+void FGCExtModule::RegisterNetworkVersionOverride()
+{
+	// Keep the override of the project and combine the checksum into its version
+
+	if (FNetworkVersion::GetLocalNetworkVersionOverride.IsBound())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("Network version override is already bound, CharacterRecipe registry checksum is combined into it"));
+
+		PreviousNetworkVersionOverride = FNetworkVersion::GetLocalNetworkVersionOverride;
+	}
+
+	FNetworkVersion::GetLocalNetworkVersionOverride.BindStatic(&FGCExtModule::GetLocalNetworkVersion);
+	FNetworkVersion::InvalidateNetworkChecksum();
+
+	bNetworkVersionOverridden = true;
+}
+
+void FGCExtModule::UnregisterNetworkVersionOverride()
+{
+	if (bNetworkVersionOverridden)
+	{
+		FNetworkVersion::GetLocalNetworkVersionOverride = PreviousNetworkVersionOverride;
+		FNetworkVersion::InvalidateNetworkChecksum();
+
+		PreviousNetworkVersionOverride.Unbind();
+
+		bNetworkVersionOverridden = false;
+	}
+}
+
+uint32 FGCExtModule::GetLocalNetworkVersion()
+{
+	const auto BaseNetworkVersion
+	{
+		PreviousNetworkVersionOverride.IsBound() ? PreviousNetworkVersionOverride.Execute() : FNetworkVersion::GetLocalNetworkVersion(false)
+	};
+
+	return HashCombine(BaseNetworkVersion, UCharacterRecipeRegistry::Get()->GetChecksum());
 }
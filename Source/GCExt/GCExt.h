@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Misc/NetworkVersion.h"
 
 /**
  *  Modules for the main features of the GameCharacterCore plugin
@@ -13,4 +14,37 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+protected:
+	/**
+	 * Build CharacterRecipeRegistry once the classes of all modules loaded at startup are registered
+	 */
+	void HandlePostEngineInit();
+
+protected:
+	//
+	// Network version override bound before this module, called to get the version the checksum is combined into
+	//
+	inline static FGetLocalNetworkVersionOverride PreviousNetworkVersionOverride;
+
+	//
+	// Whether this module has bound the network version override
+	//
+	bool bNetworkVersionOverridden{ false };
+
+protected:
+	/**
+	 * Include the checksum of CharacterRecipeRegistry in the network version
+	 * 
+	 * Tips:
+	 *	Server and client with different registries are rejected on connect.
+	 *	An override bound by the project before engine init is kept and the checksum is combined into its version.
+	 * 
+	 * Note:
+	 *	An override bound by the project after engine init replaces this one and disables the check.
+	 */
+	void RegisterNetworkVersionOverride();
+	void UnregisterNetworkVersionOverride();
+
+	static uint32 GetLocalNetworkVersion();
+
 };
@@ -0,0 +1,165 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterBakedBuild.h"
+
+#include "CharacterInitStateComponent.h"
+#include "Recipe/CharacterRecipe.h"
+#include "GCExtLogs.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterBakedBuild)
+
+
+UCharacterBakedBuild::UCharacterBakedBuild(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+
+void UCharacterBakedBuild::ApplyBakedSettings(const FCharacterRecipePawnInfo& Info) const
+{
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("Apply Baked Build (%s) to Pawn (%s)"), *GetNameSafe(this), *GetNameSafe(Info.Pawn.Get()));
+
+	// Staged so that the meshes are committed once together with the remaining CharacterRecipes
+
+	if (Info.InitStateComponent.IsValid())
+	{
+		Info.InitStateComponent->StageMeshChanges(BakedMeshes);
+	}
+	else
+	{
+		FMeshToSetMesh::ApplyToPawn(Info.Pawn.Get(), BakedMeshes);
+	}
+}
+
+bool UCharacterBakedBuild::HasBakedRecipeClass(const UClass* RecipeClass) const
+{
+	return RecipeClass && BakedRecipeClassPaths.Contains(RecipeClass->GetClassPathName());
+}
+
+
+#if WITH_EDITOR
+EDataValidationResult UCharacterBakedBuild::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	auto Result{ CombineDataValidationResults(Super::IsDataValid(ValidationErrors), EDataValidationResult::Valid) };
+
+	if (const auto* Source{ SourceCharacterSet.LoadSynchronous() })
+	{
+		if (ComputeSourceHash(Source) != SourceHash)
+		{
+			Result = CombineDataValidationResults(Result, EDataValidationResult::Invalid);
+
+			ValidationErrors.Add(FText::FromString(FString::Printf(TEXT("Source CharacterSet (%s) has been changed after baking. Bake Character Build again."), *Source->GetPathName())));
+		}
+	}
+	else if (!SourceCharacterSet.IsNull())
+	{
+		Result = CombineDataValidationResults(Result, EDataValidationResult::Invalid);
+
+		ValidationErrors.Add(FText::FromString(FString::Printf(TEXT("Source CharacterSet (%s) is not found."), *SourceCharacterSet.ToString())));
+	}
+
+	return Result;
+}
+
+void UCharacterBakedBuild::BakeFromCharacterSet(const UCharacterSet* InCharacterSet)
+{
+	check(InCharacterSet);
+
+	Modify();
+
+	SourceCharacterSet = InCharacterSet;
+	SourceHash = ComputeSourceHash(InCharacterSet);
+	BakedMeshes.Reset();
+	CharacterRecipes.Reset();
+	NumBakedRecipes = 0;
+	BakedRecipeClassPaths.Reset();
+	BakedRecipeTags.Reset();
+
+	// Bake the leading deterministic CharacterRecipes and keep the others to be executed at runtime in the same order.
+	// CharacterRecipes after the first one that cannot be baked are not baked even if they could be, since the baked settings are applied first.
+
+	auto bBaking{ true };
+
+	for (const auto& RecipeClass : InCharacterSet->GetCharacterRecipes())
+	{
+		if (!RecipeClass)
+		{
+			continue;
+		}
+
+		const auto* RecipeCDO{ RecipeClass.GetDefaultObject() };
+
+		bBaking = bBaking && RecipeCDO->CanBakeBuild();
+
+		if (bBaking)
+		{
+			RecipeCDO->BakeBuild(this);
+			++NumBakedRecipes;
+
+			// Record the class hierarchy so that a prerequisite of any super class is satisfied as it would be by IsChildOf()
+
+			for (const auto* Class{ RecipeClass.Get() }; Class && Class->IsChildOf<UCharacterRecipe>(); Class = Class->GetSuperClass())
+			{
+				BakedRecipeClassPaths.AddUnique(Class->GetClassPathName());
+			}
+
+			BakedRecipeTags.AppendTags(RecipeCDO->GetRecipeTags());
+		}
+		else
+		{
+			CharacterRecipes.Emplace(RecipeClass);
+		}
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("Baked CharacterSet (%s) into (%s) (Baked: %d, Remaining: %d, Meshes: %d)")
+		, *GetPathNameSafe(InCharacterSet), *GetPathName(), NumBakedRecipes, CharacterRecipes.Num(), BakedMeshes.Num());
+}
+
+uint32 UCharacterBakedBuild::ComputeSourceHash(const UCharacterSet* InCharacterSet)
+{
+	check(InCharacterSet);
+
+	auto Hash{ static_cast<uint32>(InCharacterSet->GetCharacterRecipes().Num()) };
+
+	for (const auto& RecipeClass : InCharacterSet->GetCharacterRecipes())
+	{
+		if (!RecipeClass)
+		{
+			continue;
+		}
+
+		Hash = FCrc::StrCrc32(*RecipeClass->GetPathName(), Hash);
+
+		// Include the settings of the CharacterRecipes that can be baked, since they are copied into the baked settings
+
+		const auto* RecipeCDO{ RecipeClass.GetDefaultObject() };
+
+		if (RecipeCDO->CanBakeBuild())
+		{
+			for (TFieldIterator<FProperty> It(RecipeClass); It; ++It)
+			{
+				FString ValueString;
+				It->ExportText_InContainer(0, ValueString, RecipeCDO, nullptr, nullptr, PPF_None);
+
+				Hash = FCrc::StrCrc32(*ValueString, Hash);
+			}
+		}
+	}
+
+	return Hash;
+}
+
+void UCharacterBakedBuild::MergeMeshSettings(const FMeshToSetMesh& InMeshToSetMesh)
+{
+	auto* BakedMesh{ BakedMeshes.FindByPredicate([&InMeshToSetMesh](const FMeshToSetMesh& Item) { return Item.MeshTag == InMeshToSetMesh.MeshTag; }) };
+
+	if (BakedMesh)
+	{
+		BakedMesh->MergeFrom(InMeshToSetMesh);
+	}
+	else
+	{
+		BakedMeshes.Emplace(InMeshToSetMesh);
+	}
+}
+#endif
@@ -0,0 +1,110 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "CharacterSet.h"
+
+#include "Recipe/CharacterSetMeshTypes.h"
+
+#include "GameplayTagContainer.h"
+
+#include "CharacterBakedBuild.generated.h"
+
+
+/**
+ * CharacterSet whose deterministic CharacterRecipes are baked into the final component settings
+ *
+ * Tips:
+ *	Created from a CharacterSet with the "Bake Character Build" action of the editor.
+ *	The leading CharacterRecipes of the source that can be baked are applied in one pass without creating any CharacterRecipe objects,
+ *	and the CharacterRecipes from the first one that cannot be baked remain in CharacterRecipes, so the order of execution does not change.
+ *
+ * Note:
+ *	Must be added by AddCharacterSet() for the baked settings to be applied.
+ */
+UCLASS(BlueprintType, Const, HideDropdown)
+class GCEXT_API UCharacterBakedBuild : public UCharacterSet
+{
+	GENERATED_BODY()
+public:
+	UCharacterBakedBuild(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+protected:
+	//
+	// CharacterSet from which this baked build was created
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	TSoftObjectPtr<const UCharacterSet> SourceCharacterSet;
+
+	//
+	// Final settings of each mesh resolved from the baked CharacterRecipes
+	//
+	// Tips:
+	//	One entry per MeshTag, later CharacterRecipes overwrite the settings of earlier ones.
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	TArray<FMeshToSetMesh> BakedMeshes;
+
+	//
+	// Number of CharacterRecipes baked from the source CharacterSet
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	int32 NumBakedRecipes{ 0 };
+
+	//
+	// Paths of the baked CharacterRecipe classes and their super classes
+	// 
+	// Tips:
+	//	Kept as paths so that the baked classes are not loaded, and matched against prerequisite classes of the remaining CharacterRecipes.
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	TArray<FTopLevelAssetPath> BakedRecipeClassPaths;
+
+	//
+	// RecipeTags of the baked CharacterRecipes
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	FGameplayTagContainer BakedRecipeTags;
+
+#if WITH_EDITORONLY_DATA
+	//
+	// Hash of the source CharacterSet when this baked build was created
+	// 
+	// Tips:
+	//	Used to detect that the source has been changed after baking.
+	//
+	UPROPERTY(VisibleAnywhere, Category = "Baked Build")
+	uint32 SourceHash{ 0 };
+#endif
+
+public:
+	virtual bool HasBakedSettings() const override { return !BakedMeshes.IsEmpty(); }
+	virtual void ApplyBakedSettings(const FCharacterRecipePawnInfo& Info) const override;
+	virtual bool HasBakedRecipeClass(const UClass* RecipeClass) const override;
+	virtual bool HasBakedRecipeTag(const FGameplayTag& RecipeTag) const override { return BakedRecipeTags.HasTag(RecipeTag); }
+
+#if WITH_EDITOR
+public:
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+
+	/**
+	 * Rebuild this baked build from the CharacterRecipes of the CharacterSet
+	 */
+	void BakeFromCharacterSet(const UCharacterSet* InCharacterSet);
+
+	/**
+	 * Returns hash of the CharacterRecipe list of the CharacterSet and the settings of its CharacterRecipes that can be baked
+	 */
+	static uint32 ComputeSourceHash(const UCharacterSet* InCharacterSet);
+
+	/**
+	 * Merge the mesh settings into the baked settings of the same MeshTag
+	 */
+	void MergeMeshSettings(const FMeshToSetMesh& InMeshToSetMesh);
+#endif
+
+public:
+	const TSoftObjectPtr<const UCharacterSet>& GetSourceCharacterSet() const { return SourceCharacterSet; }
+	const TArray<FMeshToSetMesh>& GetBakedMeshes() const { return BakedMeshes; }
+
+};
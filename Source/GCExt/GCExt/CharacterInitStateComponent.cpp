@@ -3,15 +3,19 @@
 #include "CharacterInitStateComponent.h"
 
 #include "Recipe/CharacterRecipe.h"
+#include "Recipe/CharacterRecipeSubsystem.h"
 #include "GCExtLogs.h"
+#include "GCExtStats.h"
 
 #include "InitState/InitStateTags.h"
+#include "Character/CharacterMeshAccessorInterface.h"
 
 #include "Net/UnrealNetwork.h"
 #include "Net/Core/PushModel/PushModel.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "GameFramework/Pawn.h"
 #include "Engine/ActorChannel.h"
+#include "GameplayTagsManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterInitStateComponent)
 
@@ -49,6 +53,8 @@ void UCharacterInitStateComponent::OnRegister()
 	ActiveCharacterRecipes.RegisterOwner(Pawn, this);
 
 	Super::OnRegister();
+
+	BuildMeshCache();
 }
 
 void UCharacterInitStateComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -61,7 +67,7 @@ void UCharacterInitStateComponent::EndPlay(const EEndPlayReason::Type EndPlayRea
 
 bool UCharacterInitStateComponent::CanChangeInitStateToDataAvailable(UGameFrameworkComponentManager* Manager) const
 {
-	// Return false if not yet committed
+	// Return false if not all CharacterRecipes are complete
 
 	if (ActiveCharacterRecipes.GetCurrentApplicationState() != ECharacterRecipesApplicationState::Complete)
 	{
@@ -126,6 +132,7 @@ TArray<FPendingCharacterRecipeHandle> UCharacterInitStateComponent::AddMultipePe
 	}
 
 	TArray<FPendingCharacterRecipeHandle> OutHandles;
+	OutHandles.Reserve(InClasses.Num());
 
 	for (const auto& RecipeClass : InClasses)
 	{
@@ -135,6 +142,44 @@ TArray<FPendingCharacterRecipeHandle> UCharacterInitStateComponent::AddMultipePe
 	return OutHandles;
 }
 
+FPendingCharacterRecipeHandle UCharacterInitStateComponent::AddPendingStrippedCharacterRecipe(const FSoftClassPath& InClassPath)
+{
+	// Suspend if has no authority
+
+	if (!HasAuthority())
+	{
+		return FPendingCharacterRecipeHandle();
+	}
+
+	// Suspend if already commited
+
+	if (ActiveCharacterRecipes.GetCurrentApplicationState() != ECharacterRecipesApplicationState::PreCommit)
+	{
+		return FPendingCharacterRecipeHandle();
+	}
+
+	return ActiveCharacterRecipes.AddPendingStrippedCharacterRecipe(InClassPath);
+}
+
+FPendingCharacterRecipeHandle UCharacterInitStateComponent::AddPendingCharacterSet(const UCharacterSet* InCharacterSet)
+{
+	// Suspend if has no authority
+
+	if (!HasAuthority())
+	{
+		return FPendingCharacterRecipeHandle();
+	}
+
+	// Suspend if already commited
+
+	if (ActiveCharacterRecipes.GetCurrentApplicationState() != ECharacterRecipesApplicationState::PreCommit)
+	{
+		return FPendingCharacterRecipeHandle();
+	}
+
+	return ActiveCharacterRecipes.AddPendingCharacterSet(InCharacterSet);
+}
+
 void UCharacterInitStateComponent::RemovePendingCharacterRecipe(const FPendingCharacterRecipeHandle& InHandle)
 {
 	// Suspend if has no authority
@@ -211,8 +256,14 @@ void UCharacterInitStateComponent::CommitPendingCharacterRecipes()
 		return;
 	}
 
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_CommitPendingRecipes);
+
 	ActiveCharacterRecipes.CommitPendingCharacterRecipes();
 
+	// The container is replicated push-based, so mark it dirty so that both the legacy replication and Iris pick up the changes
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(UCharacterInitStateComponent, ActiveCharacterRecipes, this);
+
 	HandleAllRecipesCommitted();
 }
 
@@ -220,12 +271,18 @@ void UCharacterInitStateComponent::HandleAllRecipesCommitted()
 {
 	ActiveCharacterRecipes.ApplicationState = ECharacterRecipesApplicationState::Commited;
 	ActiveCharacterRecipes.ExecuteCharacterRecipeSetup();
-
-	CheckDefaultInitialization();
 }
 
 void UCharacterInitStateComponent::OnRep_CommitRecipes()
 {
+	// Suspend if already commited
+	// Entries replicated after this are started by the container in PostReplicatedAdd()
+
+	if (ActiveCharacterRecipes.GetCurrentApplicationState() != ECharacterRecipesApplicationState::PreCommit)
+	{
+		return;
+	}
+
 	HandleAllRecipesCommitted();
 }
 
@@ -242,23 +299,129 @@ void UCharacterInitStateComponent::ReleaseCharacterRecipes()
 
 void UCharacterInitStateComponent::HandleRecipeSetupFinished(const FActiveCharacterRecipeHandle& Handle)
 {
+	const auto bFirstNotification{ ActiveCharacterRecipes.RecipesPendingFinish.IsEmpty() };
+
 	ActiveCharacterRecipes.AddActiveRecipeHandlePendingFinish(Handle);
 
-	if (!DelayedCheckRecipeSetupFinishedTimerHandle.IsValid())
+	if (auto* Subsystem{ UWorld::GetSubsystem<UCharacterRecipeSubsystem>(GetWorld()) })
+	{
+		Subsystem->QueueRecipeSetupFinished(this, bFirstNotification);
+	}
+
+	// Process immediately in worlds without subsystem such as editor preview
+
+	else
+	{
+		HandleQueuedRecipeSetupFinished();
+	}
+}
+
+void UCharacterInitStateComponent::HandleAllRecipesFinished()
+{
+	OnAllCharacterRecipesFinished.Broadcast();
+
+	CheckDefaultInitialization();
+}
+
+void UCharacterInitStateComponent::HandleQueuedRecipeSetupFinished()
+{
+	ActiveCharacterRecipes.MarkActiveRecipeHandlePendingFinish();
+}
+
+void UCharacterInitStateComponent::HandleQueuedRecipeSetup(const FActiveCharacterRecipeHandle& Handle)
+{
+	ActiveCharacterRecipes.ExecuteQueuedEntrySetup(Handle);
+}
+
+void UCharacterInitStateComponent::ResumeDeferredRecipes()
+{
+	ActiveCharacterRecipes.ResumeDeferredRecipes();
+}
+
+#pragma endregion
+
+
+#pragma region Mesh Cache
+
+USkeletalMeshComponent* UCharacterInitStateComponent::GetMeshByTag(FGameplayTag MeshTag) const
+{
+	auto* Owner{ GetOwner() };
+
+	if (!Owner || !Owner->Implements<UCharacterMeshAccessorInterface>())
+	{
+		return nullptr;
+	}
+
+	// Query again only the tag whose mesh has been removed from the owner
+
+	if (const auto* CachedMesh{ CachedMeshes.Find(MeshTag) })
 	{
-		if (auto* World{ GetWorld() })
+		if (IsCachedMeshValid(*CachedMesh))
 		{
-			DelayedCheckRecipeSetupFinishedTimerHandle =
-				World->GetTimerManager().SetTimerForNextTick(this, &ThisClass::HandleDelayedCheckRecipeSetupFinished);
+			return CachedMesh->Get();
 		}
 	}
+
+	auto* Mesh{ ICharacterMeshAccessorInterface::Execute_GetMeshByTag(Owner, MeshTag) };
+
+	CachedMeshes.Add(MeshTag, Mesh);
+
+	return Mesh;
 }
 
-void UCharacterInitStateComponent::HandleDelayedCheckRecipeSetupFinished()
+void UCharacterInitStateComponent::InvalidateMeshCache()
 {
-	ActiveCharacterRecipes.MarkActiveRecipeHandlePendingFinish();
-	DelayedCheckRecipeSetupFinishedTimerHandle.Invalidate();
-	CheckDefaultInitialization();
+	CachedMeshes.Reset();
+
+	if (IsRegistered())
+	{
+		BuildMeshCache();
+	}
+}
+
+void UCharacterInitStateComponent::BuildMeshCache()
+{
+	CachedMeshes.Reset();
+
+	auto* Owner{ GetOwner() };
+
+	if (!Owner || !Owner->Implements<UCharacterMeshAccessorInterface>())
+	{
+		return;
+	}
+
+	const auto& TagsManager{ UGameplayTagsManager::Get() };
+	const auto MeshTypeTag{ TagsManager.RequestGameplayTag(FName{ TEXTVIEW("MeshType") }, false) };
+
+	if (!MeshTypeTag.IsValid())
+	{
+		return;
+	}
+
+	// Tags without a mesh are not cached here, since components added by the construction script of the owner
+	// may not exist yet when this component is registered
+
+	for (const auto& MeshTag : TagsManager.RequestGameplayTagChildren(MeshTypeTag))
+	{
+		if (auto* Mesh{ ICharacterMeshAccessorInterface::Execute_GetMeshByTag(Owner, MeshTag) })
+		{
+			CachedMeshes.Add(MeshTag, Mesh);
+		}
+	}
+}
+
+bool UCharacterInitStateComponent::IsCachedMeshValid(const TWeakObjectPtr<USkeletalMeshComponent>& CachedMesh) const
+{
+	// Explicitly null entries stay valid until the cache is invalidated
+
+	if (CachedMesh.IsExplicitlyNull())
+	{
+		return true;
+	}
+
+	const auto* Mesh{ CachedMesh.Get() };
+
+	return Mesh && Mesh->IsRegistered() && (Mesh->GetOwner() == GetOwner());
 }
 
 #pragma endregion
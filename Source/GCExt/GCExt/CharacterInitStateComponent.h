@@ -9,6 +9,9 @@
 #include "CharacterInitStateComponent.generated.h"
 
 class UCharacterRecipe;
+class UCharacterSet;
+class UCharacterRecipeSubsystem;
+class USkeletalMeshComponent;
 
 
 /**
@@ -21,6 +24,9 @@ UCLASS(meta = (BlueprintSpawnableComponent))
 class GCEXT_API UCharacterInitStateComponent : public UInitStateComponent
 {
 	GENERATED_BODY()
+
+	friend class UCharacterRecipeSubsystem;
+
 public:
 	UCharacterInitStateComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
@@ -46,6 +52,10 @@ protected:
 protected:
 	//
 	// List of CharacterRecipe classes to be added by default
+	// 
+	// Note:
+	//	Not stripped in dedicated server cooks, so ClientOnly CharacterRecipes listed here and their assets are cooked for the server.
+	//	Add ClientOnly CharacterRecipes through a CharacterSet to strip them.
 	//
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Recipes")
 	TArray<TSubclassOf<UCharacterRecipe>> DefaultCharacterRecipes;
@@ -81,6 +91,31 @@ public:
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Recipes")
 	TArray<FPendingCharacterRecipeHandle> AddMultipePendingCharacterRecipes(const TArray<TSubclassOf<UCharacterRecipe>>& InClasses);
 
+	/**
+	 * Add CharacterRecipe class not loaded on this machine to pending list
+	 * 
+	 * Tips:
+	 *	Used for ClientOnly CharacterRecipes stripped from dedicated server cooks.
+	 *	The placeholder is not executed on the server and is replicated to clients as an index of CharacterRecipeRegistry.
+	 *
+	 * Note:
+	 *	Must have authority
+	 */
+	FPendingCharacterRecipeHandle AddPendingStrippedCharacterRecipe(const FSoftClassPath& InClassPath);
+
+	/**
+	 * Add CharacterSet to pending list
+	 * 
+	 * Tips:
+	 *	Only the reference to the CharacterSet is replicated and its CharacterRecipes are expanded locally in the same order.
+	 *	The handle can be removed with RemovePendingCharacterRecipe().
+	 *
+	 * Note:
+	 *	Must have authority
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Recipes")
+	FPendingCharacterRecipeHandle AddPendingCharacterSet(const UCharacterSet* InCharacterSet);
+
 	/**
 	 * Remove CharacterRecipe class from pending list
 	 *
@@ -146,27 +181,125 @@ private:
 	void ReleaseCharacterRecipes();
 
 
+public:
+	/**
+	 * Notify that the processing of CharacterRecipe is complete.
+	 * 
+	 * Tips:
+	 *	Notifications are queued in CharacterRecipeSubsystem and processed together once per frame.
+	 *	This is used to avoid mix-ups when multiple Recipes are completed in the same frame.
+	 */
+	void HandleRecipeSetupFinished(const FActiveCharacterRecipeHandle& Handle);
+
+	/**
+	 * Notify that the processing of all CharacterRecipes is complete.
+	 * 
+	 * Tips:
+	 *	Called by the container when the application state switches to Complete and checks the init state transition.
+	 */
+	void HandleAllRecipesFinished();
+
+	/**
+	 * Returns current application state of CharacterRecipes
+	 */
+	ECharacterRecipesApplicationState GetCharacterRecipesApplicationState() const { return ActiveCharacterRecipes.GetCurrentApplicationState(); }
+
+	//
+	// Native delegate broadcast when the processing of all CharacterRecipes is complete
+	//
+	FSimpleMulticastDelegate OnAllCharacterRecipesFinished;
+
+protected:
+	/**
+	 * Update the end flag of the CharacterRecipes queued in this frame
+	 */
+	void HandleQueuedRecipeSetupFinished();
+
+	/**
+	 * Start the setup process of the CharacterRecipe queued in CharacterRecipeSubsystem
+	 */
+	void HandleQueuedRecipeSetup(const FActiveCharacterRecipeHandle& Handle);
+
+	/**
+	 * Start the setup process of the CharacterRecipes deferred because the pawn was not significant
+	 */
+	void ResumeDeferredRecipes();
+
+public:
+	/**
+	 * Returns whether any CharacterRecipe is deferred because the pawn is not significant
+	 * 
+	 * Tips:
+	 *	Deferred ClientOnly CharacterRecipes do not block the init state and are applied when the significance rises.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	bool HasDeferredRecipes() const { return ActiveCharacterRecipes.HasDeferredRecipes(); }
+
+	/**
+	 * Stage the mesh changes of a CharacterRecipe to be committed at once with the changes of other CharacterRecipes
+	 * 
+	 * Tips:
+	 *	Staged changes are committed at the end of each setup pass, before dependent CharacterRecipes start,
+	 *	and before any CharacterRecipe that cannot start with staged mesh changes (including all Blueprint CharacterRecipes) starts.
+	 */
+	void StageMeshChanges(TConstArrayView<FMeshToSetMesh> InMeshesToSetMesh) { ActiveCharacterRecipes.StageMeshChanges(InMeshesToSetMesh); }
+
+	/**
+	 * Apply the staged mesh changes immediately
+	 * 
+	 * Tips:
+	 *	Committed automatically before CharacterRecipes start, so this is only needed to read the meshes
+	 *	in the middle of an asynchronous setup process or outside of CharacterRecipes.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Recipes")
+	void CommitStagedMeshChanges() { ActiveCharacterRecipes.CommitStagedMeshChanges(); }
+
+#pragma endregion
+
+
+	/////////////////////////////////////////////////////////////////
+	// Mesh Cache
+#pragma region Mesh Cache
 protected:
 	//
-	// Timer handle for the delay between the completion of CharacterRecipe processing and init state transition check.
+	// Mapping list of MeshTag and the mesh returned by ICharacterMeshAccessorInterface of the owner
 	// 
 	// Tips:
-	//	This is used to avoid mix-ups when multiple Recipes are completed in the same frame.
+	//	Built for the "MeshType" tags the owner has a mesh for when this component is registered, other tags are added on first query.
+	//	Explicitly null entries are tags the owner has no mesh for, so they are not queried again.
 	//
-	UPROPERTY(Transient)
-	FTimerHandle DelayedCheckRecipeSetupFinishedTimerHandle;
+	mutable TMap<FGameplayTag, TWeakObjectPtr<USkeletalMeshComponent>> CachedMeshes;
+
+protected:
+	/**
+	 * Query the meshes of all "MeshType" tags from the owner and cache them
+	 */
+	void BuildMeshCache();
+
+	/**
+	 * Returns whether the cached mesh is still a registered component of the owner
+	 */
+	bool IsCachedMeshValid(const TWeakObjectPtr<USkeletalMeshComponent>& CachedMesh) const;
 
 public:
 	/**
-	 * Notify that the processing of CharacterRecipe is complete.
+	 * Returns the mesh of the owner with the specified tag
+	 * 
+	 * Tips:
+	 *	Queries ICharacterMeshAccessorInterface only the first time for each tag, so it is cheap to call from CharacterRecipes.
 	 */
-	void HandleRecipeSetupFinished(const FActiveCharacterRecipeHandle& Handle);
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Mesh")
+	USkeletalMeshComponent* GetMeshByTag(FGameplayTag MeshTag) const;
 
-protected:
 	/**
-	 * Update the end flag of the CharacterRecipe that has been processed in the previous frame and send a signal for synchronization
+	 * Clear the cached meshes
+	 * 
+	 * Tips:
+	 *	Call this when the owner adds a mesh component or changes the mesh returned for a tag.
+	 *	Removed, unregistered or destroyed mesh components are detected per tag and queried again without this.
 	 */
-	void HandleDelayedCheckRecipeSetupFinished();
+	UFUNCTION(BlueprintCallable, Category = "Mesh")
+	void InvalidateMeshCache();
 
 #pragma endregion
 
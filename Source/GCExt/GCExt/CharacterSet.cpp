@@ -3,6 +3,15 @@
 #include "CharacterSet.h"
 
 #include "CharacterInitStateComponent.h"
+#include "Recipe/CharacterRecipe.h"
+#include "GCExtLogs.h"
+
+#include "Engine/AssetManager.h"
+
+#if WITH_EDITOR
+#include "UObject/ObjectSaveContext.h"
+#include "Interfaces/ITargetPlatform.h"
+#endif
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterSet)
 
@@ -12,10 +21,200 @@ UCharacterSet::UCharacterSet(const FObjectInitializer& ObjectInitializer)
 {
 }
 
+#if WITH_EDITORONLY_DATA
+void UCharacterSet::UpdateAssetBundleData()
+{
+	Super::UpdateAssetBundleData();
+
+	if (!UAssetManager::IsInitialized())
+	{
+		return;
+	}
+
+	// Collect soft references of the CharacterRecipes to be added into the bundles of this CharacterSet
+
+	const auto& AssetManager{ UAssetManager::Get() };
+
+	for (const auto& RecipeClass : CharacterRecipes)
+	{
+		if (RecipeClass)
+		{
+			AssetManager.InitializeAssetBundlesFromMetadata(RecipeClass.GetDefaultObject(), AssetBundleData, GetFName());
+		}
+	}
+}
+#endif
+
+void UCharacterSet::GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const
+{
+	Super::GetAssetRegistryTags(OutTags);
+
+	// Gathered while saving, after PreSave() has stripped the CharacterRecipes
+
+	if (!StrippedRecipes.IsEmpty())
+	{
+		TStringBuilder<512> ClassPaths;
+
+		for (const auto& StrippedRecipe : StrippedRecipes)
+		{
+			if (ClassPaths.Len() > 0)
+			{
+				ClassPaths << TEXT(',');
+			}
+
+			ClassPaths << StrippedRecipe.ClassPath.ToString();
+		}
+
+		OutTags.Emplace(NAME_StrippedRecipesTag, ClassPaths.ToString(), FAssetRegistryTag::TT_Hidden);
+	}
+}
+
+#if WITH_EDITOR
+EDataValidationResult UCharacterSet::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	auto Result{ CombineDataValidationResults(Super::IsDataValid(ValidationErrors), EDataValidationResult::Valid) };
+
+	// Validated once here instead of on every pawn the CharacterSet is added to
+
+	TArray<const UCharacterRecipe*> Recipes;
+
+	for (const auto& RecipeClass : CharacterRecipes)
+	{
+		if (RecipeClass)
+		{
+			Recipes.Emplace(RecipeClass.GetDefaultObject());
+		}
+	}
+
+	TArray<const UCharacterRecipe*> Cycle;
+
+	if (UCharacterRecipe::FindPrerequisiteCycle(Recipes, Cycle))
+	{
+		Result = CombineDataValidationResults(Result, EDataValidationResult::Invalid);
+
+		const auto CycleString{ FString::JoinBy(Cycle, TEXT(" -> "), [](const UCharacterRecipe* Recipe) { return GetNameSafe(Recipe->GetClass()); }) };
+
+		ValidationErrors.Add(FText::FromString(FString::Printf(TEXT("Circular dependency between CharacterRecipes (%s)."), *CycleString)));
+	}
+
+	return Result;
+}
+
+void UCharacterSet::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	// Strip only when cooking for dedicated servers, ClientOnly CharacterRecipes are never executed there.
+	// Stripped before Super::PreSave() so that the asset bundles updated there do not include the ClientOnly CharacterRecipes.
+
+	const auto* TargetPlatform{ ObjectSaveContext.GetTargetPlatform() };
+
+	if (ObjectSaveContext.IsCooking() && TargetPlatform && TargetPlatform->IsServerOnly())
+	{
+		StripClientOnlyRecipes();
+	}
+
+	Super::PreSave(ObjectSaveContext);
+}
+
+void UCharacterSet::PostSave(FObjectPostSaveContext ObjectSaveContext)
+{
+	Super::PostSave(ObjectSaveContext);
+
+	RestoreStrippedRecipes();
+}
+
+void UCharacterSet::StripClientOnlyRecipes()
+{
+	StrippedRecipes.Reset();
+
+	for (auto Index{ 0 }; Index < CharacterRecipes.Num(); ++Index)
+	{
+		auto& RecipeClass{ CharacterRecipes[Index] };
+
+		if (RecipeClass && (RecipeClass.GetDefaultObject()->GetNetExecutionPolicy() == ECharacterRecipeNetExecutionPolicy::ClientOnly))
+		{
+			StrippedRecipes.Emplace(Index, RecipeClass->GetClassPathName());
+
+			RecipeClass = nullptr;
+		}
+	}
+
+	UE_CLOG(!StrippedRecipes.IsEmpty(), LogGameExt_CharacterRecipe, Log, TEXT("Stripped %d ClientOnly CharacterRecipes from CharacterSet (%s) for dedicated server"), StrippedRecipes.Num(), *GetPathName());
+}
+
+void UCharacterSet::RestoreStrippedRecipes()
+{
+	for (const auto& StrippedRecipe : StrippedRecipes)
+	{
+		if (CharacterRecipes.IsValidIndex(StrippedRecipe.Index))
+		{
+			CharacterRecipes[StrippedRecipe.Index] = FSoftClassPath(StrippedRecipe.ClassPath).TryLoadClass<UCharacterRecipe>();
+		}
+	}
+
+	StrippedRecipes.Reset();
+}
+#endif
+
 void UCharacterSet::AddCharacterRecipes(UCharacterInitStateComponent* InitStateComponent, TArray<FPendingCharacterRecipeHandle>& OutHandles) const
 {
-	if (InitStateComponent)
+	if (!InitStateComponent)
+	{
+		return;
+	}
+
+	UE_CLOG(HasBakedSettings(), LogGameExt_CharacterRecipe, Warning, TEXT("CharacterSet (%s) has baked settings that are only applied when added by AddCharacterSet()"), *GetPathName());
+
+	if (StrippedRecipes.IsEmpty())
 	{
 		OutHandles = InitStateComponent->AddMultipePendingCharacterRecipes(CharacterRecipes);
+		return;
 	}
+
+	// Add the stripped CharacterRecipes as placeholders at their original position
+
+	OutHandles.Reset(CharacterRecipes.Num());
+
+	auto StrippedIt{ 0 };
+
+	for (auto Index{ 0 }; Index < CharacterRecipes.Num(); ++Index)
+	{
+		if ((StrippedIt < StrippedRecipes.Num()) && (StrippedRecipes[StrippedIt].Index == Index))
+		{
+			OutHandles.Emplace(InitStateComponent->AddPendingStrippedCharacterRecipe(FSoftClassPath(StrippedRecipes[StrippedIt].ClassPath)));
+			++StrippedIt;
+		}
+		else
+		{
+			OutHandles.Emplace(InitStateComponent->AddPendingCharacterRecipe(CharacterRecipes[Index]));
+		}
+	}
+}
+
+void UCharacterSet::AddCharacterSet(UCharacterInitStateComponent* InitStateComponent, FPendingCharacterRecipeHandle& OutHandle) const
+{
+	if (InitStateComponent)
+	{
+		OutHandle = InitStateComponent->AddPendingCharacterSet(this);
+	}
+}
+
+TSharedPtr<FStreamableHandle> UCharacterSet::PreloadCharacterSet(const TSoftObjectPtr<const UCharacterSet>& InCharacterSet, const TArray<FName>& Bundles, FStreamableDelegate Delegate, TAsyncLoadPriority Priority)
+{
+	if (InCharacterSet.IsNull())
+	{
+		return nullptr;
+	}
+
+	auto& AssetManager{ UAssetManager::Get() };
+
+	const auto PrimaryAssetId{ AssetManager.GetPrimaryAssetIdForPath(InCharacterSet.ToSoftObjectPath()) };
+
+	if (PrimaryAssetId.IsValid())
+	{
+		return AssetManager.PreloadPrimaryAssets({ PrimaryAssetId }, Bundles, false, MoveTemp(Delegate), Priority);
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterSet (%s) is not registered in AssetManager, bundles will not be preloaded"), *InCharacterSet.ToString());
+
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(InCharacterSet.ToSoftObjectPath(), MoveTemp(Delegate), Priority);
 }
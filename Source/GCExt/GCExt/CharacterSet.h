@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Engine/DataAsset.h"
+#include "Engine/StreamableManager.h"
 
 #include "Recipe/PendingCharacterRecipeHandle.h"
 
@@ -10,6 +11,41 @@
 
 class UCharacterInitStateComponent;
 class UCharacterRecipe;
+struct FCharacterRecipePawnInfo;
+struct FGameplayTag;
+
+
+/**
+ * CharacterRecipe class stripped from the CharacterSet in dedicated server cooks
+ * 
+ * Tips:
+ *	Only the path is kept so that the class and its assets are not cooked,
+ *	and the server can still replicate it to clients as an index of CharacterRecipeRegistry.
+ */
+USTRUCT()
+struct FCharacterSetStrippedRecipe
+{
+	GENERATED_BODY()
+public:
+	FCharacterSetStrippedRecipe() {}
+	FCharacterSetStrippedRecipe(int32 InIndex, const FTopLevelAssetPath& InClassPath)
+		: Index(InIndex), ClassPath(InClassPath)
+	{}
+
+public:
+	//
+	// Index in the CharacterRecipes of the CharacterSet
+	//
+	UPROPERTY()
+	int32 Index{ INDEX_NONE };
+
+	//
+	// Path of the stripped CharacterRecipe class
+	//
+	UPROPERTY()
+	FTopLevelAssetPath ClassPath;
+
+};
 
 
 /**
@@ -22,6 +58,33 @@ class GCEXT_API UCharacterSet : public UPrimaryDataAsset
 public:
 	UCharacterSet(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
+	//
+	// Asset bundle name used by clients
+	//
+	inline static const FName NAME_ClientBundle{ TEXTVIEW("Client") };
+
+	//
+	// Asset bundle name used by servers
+	//
+	inline static const FName NAME_ServerBundle{ TEXTVIEW("Server") };
+
+	//
+	// AssetRegistry tag listing the paths of the CharacterRecipe classes stripped in dedicated server cooks
+	//
+	inline static const FName NAME_StrippedRecipesTag{ TEXTVIEW("StrippedRecipes") };
+
+#if WITH_EDITORONLY_DATA
+	virtual void UpdateAssetBundleData() override;
+#endif
+
+	virtual void GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const override;
+
+#if WITH_EDITOR
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+	virtual void PostSave(FObjectPostSaveContext ObjectSaveContext) override;
+#endif
+
 protected:
 	//
 	// List of CharacterRecipe classes to be added by the character
@@ -32,11 +95,102 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "CharacterSet")
 	TArray<TSubclassOf<UCharacterRecipe>> CharacterRecipes;
 
+	//
+	// List of ClientOnly CharacterRecipe classes stripped in dedicated server cooks
+	// 
+	// Tips:
+	//	Only has values in the data cooked for dedicated servers.
+	//	The paths are also written to the AssetRegistry tag NAME_StrippedRecipesTag, so that CharacterRecipeRegistry
+	//	of the server registers the stripped classes and keeps the same indices as the client.
+	//
+	UPROPERTY()
+	TArray<FCharacterSetStrippedRecipe> StrippedRecipes;
+
+#if WITH_EDITOR
+protected:
+	/**
+	 * Remove ClientOnly CharacterRecipes from CharacterRecipes and keep their paths in StrippedRecipes
+	 *
+	 * Note:
+	 *	Only the CharacterRecipes list of CharacterSets is stripped. A ClientOnly class is still cooked for the server
+	 *	if anything else hard-references it, such as DefaultCharacterRecipes of CharacterInitStateComponent
+	 *	or a TSubclassOf property of another CharacterRecipe. Prerequisites are soft references and do not keep it.
+	 */
+	void StripClientOnlyRecipes();
+
+	/**
+	 * Restore CharacterRecipes removed by StripClientOnlyRecipes()
+	 */
+	void RestoreStrippedRecipes();
+#endif
+
 public:
+	/**
+	 * Returns list of CharacterRecipe classes to be added by the character
+	 */
+	const TArray<TSubclassOf<UCharacterRecipe>>& GetCharacterRecipes() const { return CharacterRecipes; }
+
+	/**
+	 * Returns list of ClientOnly CharacterRecipe classes stripped in dedicated server cooks
+	 */
+	const TArray<FCharacterSetStrippedRecipe>& GetStrippedRecipes() const { return StrippedRecipes; }
+
+	/**
+	 * Returns whether this CharacterSet has settings baked from CharacterRecipes
+	 */
+	virtual bool HasBakedSettings() const { return false; }
+
+	/**
+	 * Apply the settings baked from CharacterRecipes to the pawn
+	 * 
+	 * Tips:
+	 *	Executed once before the setup process of the CharacterRecipes of this CharacterSet starts.
+	 *	Only executed if this CharacterSet is added by AddCharacterSet().
+	 */
+	virtual void ApplyBakedSettings(const FCharacterRecipePawnInfo& Info) const {}
+
+	/**
+	 * Returns whether a CharacterRecipe of the class or its subclass has been baked into this CharacterSet
+	 * 
+	 * Tips:
+	 *	Baked CharacterRecipes are not added to the pawn, so they satisfy the prerequisites of other CharacterRecipes through this.
+	 */
+	virtual bool HasBakedRecipeClass(const UClass* RecipeClass) const { return false; }
+
+	/**
+	 * Returns whether a CharacterRecipe with the tag has been baked into this CharacterSet
+	 */
+	virtual bool HasBakedRecipeTag(const FGameplayTag& RecipeTag) const { return false; }
+
 	/**
 	 * Add a CharacterRecipe to Character
+	 * 
+	 * Tips:
+	 *	CharacterRecipes stripped in dedicated server cooks are added as placeholders that are only replicated to clients.
 	 */
 	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Recipes")
 	void AddCharacterRecipes(UCharacterInitStateComponent* InitStateComponent, TArray<FPendingCharacterRecipeHandle>& OutHandles) const;
 
+	/**
+	 * Add this CharacterSet to Character as a single entry
+	 * 
+	 * Tips:
+	 *	Only the reference to this CharacterSet is replicated and the CharacterRecipes are expanded locally on each machine.
+	 */
+	UFUNCTION(BlueprintAuthorityOnly, BlueprintCallable, Category = "Recipes")
+	void AddCharacterSet(UCharacterInitStateComponent* InitStateComponent, FPendingCharacterRecipeHandle& OutHandle) const;
+
+	/**
+	 * Preload the CharacterSet and the assets of the specified bundles before the pawn spawns
+	 * 
+	 * Tips:
+	 *	The assets are kept loaded while the returned handle is active.
+	 *	If the CharacterSet is not registered as a primary asset in the AssetManager, only the CharacterSet itself is loaded.
+	 */
+	static TSharedPtr<FStreamableHandle> PreloadCharacterSet(
+		const TSoftObjectPtr<const UCharacterSet>& InCharacterSet
+		, const TArray<FName>& Bundles
+		, FStreamableDelegate Delegate = FStreamableDelegate()
+		, TAsyncLoadPriority Priority = FStreamableManager::DefaultAsyncLoadPriority);
+
 };
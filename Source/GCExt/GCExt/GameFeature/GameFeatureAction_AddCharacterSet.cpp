@@ -4,6 +4,7 @@
 
 #include "CharacterInitStateComponent.h"
 #include "CharacterSet.h"
+#include "GCExtLogs.h"
 
 #include "Character/GFCPawn.h"
 
@@ -47,6 +48,18 @@ void UGameFeatureAction_AddCharacterSet::OnGameFeatureActivating(FGameFeatureAct
 		Reset(ActiveData);
 	}
 
+	// Start loading CharacterSet before pawns are extended
+
+	TArray<FName> Bundles{ UCharacterSet::NAME_ServerBundle };
+
+	if (!IsRunningDedicatedServer())
+	{
+		Bundles.Add(UCharacterSet::NAME_ClientBundle);
+	}
+
+	ActiveData.CharacterSetLoadHandle = UCharacterSet::PreloadCharacterSet(CharacterSet, Bundles,
+		FStreamableDelegate::CreateUObject(this, &ThisClass::HandleCharacterSetLoaded, FGameFeatureStateChangeContext(Context)));
+
 	Super::OnGameFeatureActivating(Context);
 }
 
@@ -92,6 +105,23 @@ void UGameFeatureAction_AddCharacterSet::AddToWorld(const FWorldContext& WorldCo
 void UGameFeatureAction_AddCharacterSet::Reset(FPerContextData& ActiveData)
 {
 	ActiveData.ExtensionRequestHandles.Empty();
+	ActiveData.PawnsWaitingForCharacterSet.Empty();
+
+	// Release CharacterSet so that it is not kept resident after deactivation
+
+	if (ActiveData.CharacterSetLoadHandle.IsValid())
+	{
+		if (ActiveData.CharacterSetLoadHandle->IsLoadingInProgress())
+		{
+			ActiveData.CharacterSetLoadHandle->CancelHandle();
+		}
+		else
+		{
+			ActiveData.CharacterSetLoadHandle->ReleaseHandle();
+		}
+
+		ActiveData.CharacterSetLoadHandle.Reset();
+	}
 }
 
 void UGameFeatureAction_AddCharacterSet::HandlePawnExtension(AActor* Actor, FName EventName, FGameFeatureStateChangeContext ChangeContext)
@@ -119,20 +149,74 @@ void UGameFeatureAction_AddCharacterSet::AddCharacterSetForPawn(APawn* Pawn, FPe
 {
 	if (Pawn->HasAuthority())
 	{
-		if (auto* Component{ Pawn->FindComponentByClass<UCharacterInitStateComponent>() })
+		// Queue pawns that arrive before CharacterSet has been loaded
+
+		if (ActiveData.CharacterSetLoadHandle.IsValid() && ActiveData.CharacterSetLoadHandle->IsLoadingInProgress())
+		{
+			ActiveData.PawnsWaitingForCharacterSet.AddUnique(Pawn);
+			return;
+		}
+
+		const auto* LoadedCharacterSet{ CharacterSet.Get() };
+
+		if (!LoadedCharacterSet)
 		{
-			const auto* LoadedCharacterSet
-			{
-				CharacterSet.IsValid() ? CharacterSet.Get() : CharacterSet.LoadSynchronous()
-			};
+			UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterSet (%s) was not loaded asynchronously, loading synchronously"), *CharacterSet.ToString());
+
+			LoadedCharacterSet = CharacterSet.LoadSynchronous();
+		}
+
+		ApplyCharacterSetToPawn(Pawn, LoadedCharacterSet);
+	}
+}
+
+void UGameFeatureAction_AddCharacterSet::ApplyCharacterSetToPawn(APawn* Pawn, const UCharacterSet* LoadedCharacterSet)
+{
+	if (!LoadedCharacterSet)
+	{
+		return;
+	}
 
+	if (auto* Component{ Pawn->FindComponentByClass<UCharacterInitStateComponent>() })
+	{
+		if (bAddAsCharacterSet)
+		{
+			FPendingCharacterRecipeHandle DummyHundle;
+			LoadedCharacterSet->AddCharacterSet(Component, DummyHundle);
+		}
+		else
+		{
 			TArray<FPendingCharacterRecipeHandle> DummyHundles;
-			CharacterSet->AddCharacterRecipes(Component, DummyHundles);
+			LoadedCharacterSet->AddCharacterRecipes(Component, DummyHundles);
+		}
+
+		if (bCommitImmediately)
+		{
+			Component->CommitPendingCharacterRecipes();
+		}
+	}
+}
+
+void UGameFeatureAction_AddCharacterSet::HandleCharacterSetLoaded(FGameFeatureStateChangeContext ChangeContext)
+{
+	auto* ActiveData{ ContextData.Find(ChangeContext) };
+
+	if (!ActiveData)
+	{
+		return;
+	}
+
+	// Apply CharacterSet to all queued pawns in one batch
 
-			if (bCommitImmediately)
-			{
-				Component->CommitPendingCharacterRecipes();
-			}
+	const auto* LoadedCharacterSet{ CharacterSet.Get() };
+	const auto WaitingPawns{ MoveTemp(ActiveData->PawnsWaitingForCharacterSet) };
+	ActiveData->PawnsWaitingForCharacterSet.Reset();
+
+	for (const auto& WeakPawn : WaitingPawns)
+	{
+		if (auto* Pawn{ WeakPawn.Get() })
+		{
+			ApplyCharacterSetToPawn(Pawn, LoadedCharacterSet);
 		}
 	}
 }
@@ -4,6 +4,8 @@
 
 #include "GameFeature/GameFeatureAction_WorldActionBase.h"
 
+#include "Engine/StreamableManager.h"
+
 #include "GameFeatureAction_AddCharacterSet.generated.h"
 
 class UCharacterSet;
@@ -27,6 +29,10 @@ private:
 	struct FPerContextData
 	{
 		TArray<TSharedPtr<FComponentRequestHandle>> ExtensionRequestHandles;
+
+		TSharedPtr<FStreamableHandle> CharacterSetLoadHandle;
+
+		TArray<TWeakObjectPtr<APawn>> PawnsWaitingForCharacterSet;
 	};
 
 	TMap<FGameFeatureStateChangeContext, FPerContextData> ContextData;
@@ -44,6 +50,16 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "CharacterSet")
 	bool bCommitImmediately{ true };
 
+	//
+	// Whether to add the CharacterSet as a single entry instead of adding each CharacterRecipe
+	// 
+	// Tips:
+	//	Only the reference to the CharacterSet is replicated and the CharacterRecipes are expanded locally on each machine.
+	//	The CharacterSet must be loadable on the client, and its CharacterRecipes start once its reference has been mapped.
+	//
+	UPROPERTY(EditAnywhere, Category = "CharacterSet")
+	bool bAddAsCharacterSet{ false };
+
 public:
 	virtual void OnGameFeatureActivating(FGameFeatureActivatingContext& Context) override;
 	virtual void OnGameFeatureDeactivating(FGameFeatureDeactivatingContext& Context) override;
@@ -54,5 +70,7 @@ private:
 	void Reset(FPerContextData& ActiveData);
 	void HandlePawnExtension(AActor* Actor, FName EventName, FGameFeatureStateChangeContext ChangeContext);
 	void AddCharacterSetForPawn(APawn* Pawn, FPerContextData& ActiveData);
+	void ApplyCharacterSetToPawn(APawn* Pawn, const UCharacterSet* LoadedCharacterSet);
+	void HandleCharacterSetLoaded(FGameFeatureStateChangeContext ChangeContext);
 
 };
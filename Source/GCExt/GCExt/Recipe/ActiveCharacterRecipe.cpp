@@ -3,9 +3,19 @@
 #include "ActiveCharacterRecipe.h"
 
 #include "Recipe/CharacterRecipe.h"
+#include "Recipe/CharacterRecipeInstancePool.h"
+#include "Recipe/CharacterRecipeSubsystem.h"
+#include "Recipe/CharacterRecipeBuildCache.h"
+#include "CharacterSet.h"
+#include "CharacterInitStateComponent.h"
 #include "GCExtLogs.h"
+#include "GCExtStats.h"
 
 #include "GameFramework/Pawn.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/NetConnection.h"
+#include "Engine/ChildConnection.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(ActiveCharacterRecipe)
 
@@ -19,12 +29,79 @@ FActiveCharacterRecipe::FActiveCharacterRecipe(TSubclassOf<UCharacterRecipe> InC
 	: RecipeCDO(InClass ? InClass.GetDefaultObject() : nullptr)
 {
 	Handle.GenerateNewHandle();
+
+	AssignRecipeClassIndex();
 }
 
 FActiveCharacterRecipe::FActiveCharacterRecipe(const UCharacterRecipe* InCDO)
 	: RecipeCDO(InCDO)
 {
 	Handle.GenerateNewHandle();
+
+	AssignRecipeClassIndex();
+}
+
+FActiveCharacterRecipe::FActiveCharacterRecipe(const UCharacterSet* InCharacterSet)
+	: CharacterSet(InCharacterSet)
+	, bFinished(true)
+{
+	Handle.GenerateNewHandle();
+}
+
+FActiveCharacterRecipe::FActiveCharacterRecipe(const FSoftClassPath& InPlaceholderClassPath)
+	: RecipeClassIndex(UCharacterRecipeRegistry::Get()->GetClassIndexByPath(InPlaceholderClassPath))
+	, bFinished(true)
+{
+	Handle.GenerateNewHandle();
+
+	if (!RecipeClassIndex.IsValid())
+	{
+		RecipeClassPath = InPlaceholderClassPath;
+	}
+}
+
+
+void FActiveCharacterRecipe::AssignRecipeClassIndex()
+{
+	if (RecipeCDO)
+	{
+		RecipeClassIndex = UCharacterRecipeRegistry::Get()->GetClassIndex(RecipeCDO->GetClass());
+
+		// Replicate the class path instead if the registry does not know the class
+
+		if (!RecipeClassIndex.IsValid())
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterRecipe class (%s) is not registered in CharacterRecipeRegistry, replicating its class path instead"), *GetNameSafe(RecipeCDO->GetClass()));
+
+			RecipeClassPath = FSoftClassPath(RecipeCDO->GetClass());
+		}
+	}
+}
+
+bool FActiveCharacterRecipe::ResolveRecipeCDO()
+{
+	TSubclassOf<UCharacterRecipe> RecipeClass;
+
+	if (RecipeClassIndex.IsValid())
+	{
+		RecipeClass = UCharacterRecipeRegistry::Get()->ResolveClass(RecipeClassIndex);
+	}
+	else if (RecipeClassPath.IsValid())
+	{
+		RecipeClass = RecipeClassPath.TryLoadClass<UCharacterRecipe>();
+	}
+
+	RecipeCDO = RecipeClass ? RecipeClass.GetDefaultObject() : nullptr;
+
+	if (!RecipeCDO)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("[%s] Failed to resolve CharacterRecipe class (Index: %s, Path: %s). Check that the CharacterRecipe registry of server and client are the same.")
+			, *Handle.ToString(), *RecipeClassIndex.ToString(), *RecipeClassPath.ToString());
+
+		return false;
+	}
+
+	return true;
 }
 
 
@@ -42,32 +119,61 @@ void FActiveCharacterRecipe::TryCreateInstance(APawn* Owner, bool bHasAuthority,
 {
 	if (RecipeCDO && RecipeCDO->GetInstancingPolicy() == ECharacterRecipeInstancingPolicy::Instanced)
 	{
-		const auto ExecutionPolicy{ RecipeCDO->GetNetExecutionPolicy() };
-		
-		if ((ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::Both)
-			|| (bHasAuthority && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ServerOnly)
-			|| (bLocallyControlled && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::LocalOnly)
-			|| (!bIsDedicatedServer && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ClientOnly))
+		if (RecipeCDO->ShouldExecuteOn(bHasAuthority, bLocallyControlled, bIsDedicatedServer))
 		{
+			// Reuse an instance from the pool if the CharacterRecipe allows it
+
+			if (RecipeCDO->IsInstancePoolingAllowed())
+			{
+				if (auto* InstancePool{ UWorld::GetSubsystem<UCharacterRecipeInstancePool>(Owner->GetWorld()) })
+				{
+					RecipeInstance = InstancePool->AcquireInstance(RecipeCDO->GetClass());
+					return;
+				}
+			}
+
 			RecipeInstance = NewObject<UCharacterRecipe>(Owner, RecipeCDO->GetClass());
 		}
 	}
 }
 
-void FActiveCharacterRecipe::TryExecuteSetup(APawn* Owner, UCharacterInitStateComponent* OwnerComponent, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer)
+bool FActiveCharacterRecipe::TryExecuteSetup(APawn* Owner, UCharacterInitStateComponent* OwnerComponent, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer)
 {
+	if (!RecipeCDO)
+	{
+		return false;
+	}
+
 	auto PawnInfo{ FCharacterRecipePawnInfo(Handle, Owner, OwnerComponent) };
-	const auto ExecutionPolicy{ RecipeCDO->GetNetExecutionPolicy() };
 
 	// Execute if possible.
 
 	const auto bIsLocallyViewd{ Owner->IsLocallyViewed() };
 
-	if ((ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::Both)
-		|| (bHasAuthority && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ServerOnly)
-		|| (bLocallyControlled && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::LocalOnly)
-		|| (!bIsDedicatedServer && ExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ClientOnly))
+	if (RecipeCDO->ShouldExecuteOn(bHasAuthority, bLocallyControlled, bIsDedicatedServer))
 	{
+		TraceRegionName = GCExtStats::BeginRecipeRegion(Owner, RecipeCDO->GetClass(), Handle);
+
+		// Apply the cached output if a pawn with the same build has already been set up
+
+		if (BuildCacheKey.IsValid())
+		{
+			if (auto* BuildCache{ UWorld::GetSubsystem<UCharacterRecipeBuildCache>(Owner->GetWorld()) })
+			{
+				if (const auto* BuildOutput{ BuildCache->FindBuildOutput(BuildCacheKey) })
+				{
+					// The instance is never set up, so it is released without OnDestroy() which would undo a setup that did not happen
+
+					ReleaseRecipeInstance();
+
+					RecipeCDO->HandleApplyBuildOutput(PawnInfo, BuildOutput);
+					return true;
+				}
+
+				bStoreBuildOutput = true;
+			}
+		}
+
 		if (RecipeCDO->GetInstancingPolicy() == ECharacterRecipeInstancingPolicy::Instanced)
 		{
 			if (RecipeInstance)
@@ -83,19 +189,25 @@ void FActiveCharacterRecipe::TryExecuteSetup(APawn* Owner, UCharacterInitStateCo
 		{
 			RecipeCDO->HandleStartSetupNonInstanced(PawnInfo);
 		}
+
+		return true;
 	}
 
-	// Mark as finished if not needed to run in the current environment
+	// Not needed to run in the current environment
 
-	else
-	{
-		MarkFinished();
-	}
+	return false;
 }
 
-void FActiveCharacterRecipe::MarkFinished()
+bool FActiveCharacterRecipe::MarkFinished()
 {
+	if (bFinished)
+	{
+		return false;
+	}
+
 	bFinished = true;
+
+	return true;
 }
 
 void FActiveCharacterRecipe::NotifyDestroy()
@@ -105,13 +217,36 @@ void FActiveCharacterRecipe::NotifyDestroy()
 		if (RecipeInstance)
 		{
 			RecipeInstance->HandleDestroy();
+
+			ReleaseRecipeInstance();
 		}
 	}
 }
 
+void FActiveCharacterRecipe::ReleaseRecipeInstance()
+{
+	if (RecipeInstance)
+	{
+		// Return the instance to the pool if it was acquired from it
+
+		if (auto* InstancePool{ Cast<UCharacterRecipeInstancePool>(RecipeInstance->GetOuter()) })
+		{
+			InstancePool->ReleaseInstance(RecipeInstance);
+		}
+
+		RecipeInstance = nullptr;
+	}
+}
+
 
 FString FActiveCharacterRecipe::GetDebugString()
 {
+	if (IsCharacterSetEntry())
+	{
+		return FString::Printf(TEXT("[%s](CharacterSet:%s, Expanded:%d)"),
+			*Handle.ToString(), *GetNameSafe(CharacterSet), NumExpandedEntries);
+	}
+
 	return FString::Printf(TEXT("[%s](CDO:%s, Instance:%s)"),
 		*Handle.ToString(), *GetNameSafe(RecipeCDO), *GetNameSafe(RecipeInstance));
 }
@@ -133,6 +268,47 @@ void FActiveCharacterRecipeContainer::RegisterOwner(APawn* InOwner, UCharacterIn
 
 void FActiveCharacterRecipeContainer::PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize)
 {
+	for (const auto& Index : RemovedIndices)
+	{
+		auto& Entry{ Entries[Index] };
+
+		if (Entry.bSetupDeferred)
+		{
+			--NumDeferredRecipes;
+		}
+
+		if (Entry.IsCountedAsUnfinished())
+		{
+			--NumUnfinishedRecipes;
+		}
+
+		EntryIndexMap.Remove(Entry.Handle);
+
+		// Expanded entries are kept in the list to keep the range of other CharacterSet entries, but no longer processed
+
+		for (auto ExpandedIndex{ Entry.ExpandedEntriesBegin }; ExpandedIndex < Entry.ExpandedEntriesBegin + Entry.NumExpandedEntries; ++ExpandedIndex)
+		{
+			auto& ExpandedEntry{ ExpandedEntries[ExpandedIndex] };
+
+			ExpandedEntry.NotifyDestroy();
+
+			if (ExpandedEntry.bSetupDeferred)
+			{
+				ExpandedEntry.bSetupDeferred = false;
+				--NumDeferredRecipes;
+			}
+			else if (ExpandedEntry.MarkFinished())
+			{
+				--NumUnfinishedRecipes;
+			}
+
+			EntryIndexMap.Remove(ExpandedEntry.Handle);
+		}
+	}
+
+	// Indices will be shifted by removal
+
+	bEntryIndexMapDirty = true;
 }
 
 void FActiveCharacterRecipeContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
@@ -147,12 +323,150 @@ void FActiveCharacterRecipeContainer::PostReplicatedAdd(const TArrayView<int32>
 	{
 		auto& Entry{ Entries[Index] };
 
+		// Expand the CharacterSet locally in the same order as the server
+
+		if (Entry.IsCharacterSetEntry())
+		{
+			RegisterEntry(FActiveCharacterRecipeLocation(Index, false));
+
+			TryExpandReplicatedCharacterSetEntry(Index, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
+
+			continue;
+		}
+
+		// Entries whose class cannot be resolved are treated as finished so as not to block the InitState
+
+		if (!Entry.ResolveRecipeCDO())
+		{
+			Entry.MarkFinished();
+		}
+
 		Entry.HandleCharacterRecipeComitted(Owner, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
+
+		RegisterEntry(FActiveCharacterRecipeLocation(Index, false));
+	}
+
+	// Entries committed after the first replication, e.g. when the pawn was replicated before the server committed,
+	// arrive after the client has already switched to Commited or Complete and are started here
+
+	if (!AddedIndices.IsEmpty() && (ApplicationState != ECharacterRecipesApplicationState::PreCommit))
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("[CLIENT] Execute CharacterRecipes committed after the first replication (Num: %d)"), AddedIndices.Num());
+
+		ApplicationState = ECharacterRecipesApplicationState::Commited;
+
+		ExecuteCharacterRecipeSetup();
 	}
 }
 
 void FActiveCharacterRecipeContainer::PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize)
 {
+	check(Owner);
+
+	const auto bHasAuthority{ Owner->HasAuthority() };
+	const auto bLocallyControlled{ Owner->IsLocallyControlled() };
+	const auto bIsDedicatedServer{ Owner->GetNetMode() == ENetMode::NM_DedicatedServer };
+
+	// Expand the CharacterSets whose reference has been mapped since they were added
+
+	auto NumExpanded{ 0 };
+
+	for (const auto& Index : ChangedIndices)
+	{
+		auto& Entry{ Entries[Index] };
+
+		if (Entry.IsCharacterSetEntry() && !Entry.IsCharacterSetExpanded())
+		{
+			NumExpanded += TryExpandReplicatedCharacterSetEntry(Index, bHasAuthority, bLocallyControlled, bIsDedicatedServer) ? 1 : 0;
+		}
+	}
+
+	if ((NumExpanded > 0) && (ApplicationState != ECharacterRecipesApplicationState::PreCommit))
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("[CLIENT] Execute CharacterRecipes of CharacterSets mapped after the first replication (Num: %d)"), NumExpanded);
+
+		ApplicationState = ECharacterRecipesApplicationState::Commited;
+
+		ExecuteCharacterRecipeSetup();
+	}
+}
+
+bool FActiveCharacterRecipeContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	// Check the destination connection to filter the entries by NetExecutionPolicy
+
+	bSerializingForOwner = false;
+
+	if (!DeltaParms.bIsWritingOnClient && Owner)
+	{
+		const auto* PackageMap{ Cast<UPackageMapClient>(DeltaParms.Map) };
+		const auto* Connection{ PackageMap ? PackageMap->GetConnection() : nullptr };
+		auto* OwnerConnection{ Owner->GetNetConnection() };
+
+		// Splitscreen players are owned by a child connection of the destination connection
+
+		if (auto* OwnerChildConnection{ OwnerConnection ? OwnerConnection->GetUChildConnection() : nullptr })
+		{
+			OwnerConnection = OwnerChildConnection->Parent;
+		}
+
+		bSerializingForOwner = Connection && (Connection == OwnerConnection);
+	}
+
+	return FFastArraySerializer::FastArrayDeltaSerialize<FActiveCharacterRecipe, FActiveCharacterRecipeContainer>(Entries, DeltaParms, *this);
+}
+
+bool FActiveCharacterRecipeContainer::ShouldReplicateEntry(const FActiveCharacterRecipe& Entry) const
+{
+	// CharacterSet entries and placeholders of classes not loaded on the server are always sent
+
+	if (!Entry.RecipeCDO)
+	{
+		return true;
+	}
+
+	switch (Entry.RecipeCDO->GetNetExecutionPolicy())
+	{
+	case ECharacterRecipeNetExecutionPolicy::ServerOnly:
+		return false;
+
+	case ECharacterRecipeNetExecutionPolicy::LocalOnly:
+		return bSerializingForOwner;
+
+	default:
+		return true;
+	}
+}
+
+void FActiveCharacterRecipeContainer::WarnIfEntryFilteringUnsupported() const
+{
+#if UE_WITH_IRIS
+	static auto bWarned{ false };
+
+	if (bWarned)
+	{
+		return;
+	}
+
+	const auto* NetDriver{ Owner ? Owner->GetNetDriver() : nullptr };
+
+	if (NetDriver && NetDriver->IsServer() && NetDriver->IsUsingIrisReplication())
+	{
+		bWarned = true;
+
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterRecipes are replicated with Iris, which does not filter ServerOnly and LocalOnly entries per connection. ")
+			TEXT("All entries are sent to all clients and skipped there by NetExecutionPolicy."));
+	}
+#endif
+}
+
+void FActiveCharacterRecipeContainer::AddStructReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& PendingRecipe : PendingRecipes)
+	{
+		Collector.AddReferencedObject(PendingRecipe.RecipeClass);
+		Collector.AddReferencedObject(PendingRecipe.CharacterSet);
+	}
 }
 
 
@@ -163,7 +477,37 @@ FPendingCharacterRecipeHandle FActiveCharacterRecipeContainer::AddPendingCharact
 		FPendingCharacterRecipeHandle NewHandle;
 		NewHandle.GenerateNewHandle();
 
-		PendingRecipeMap.Add(NewHandle, CharacterRecipe);
+		PendingRecipes.Emplace(NewHandle, CharacterRecipe.Get());
+
+		return NewHandle;
+	}
+
+	return FPendingCharacterRecipeHandle();
+}
+
+FPendingCharacterRecipeHandle FActiveCharacterRecipeContainer::AddPendingStrippedCharacterRecipe(const FSoftClassPath& InClassPath)
+{
+	if (InClassPath.IsValid())
+	{
+		FPendingCharacterRecipeHandle NewHandle;
+		NewHandle.GenerateNewHandle();
+
+		PendingRecipes.Emplace(NewHandle, InClassPath);
+
+		return NewHandle;
+	}
+
+	return FPendingCharacterRecipeHandle();
+}
+
+FPendingCharacterRecipeHandle FActiveCharacterRecipeContainer::AddPendingCharacterSet(const UCharacterSet* InCharacterSet)
+{
+	if (InCharacterSet)
+	{
+		FPendingCharacterRecipeHandle NewHandle;
+		NewHandle.GenerateNewHandle();
+
+		PendingRecipes.Emplace(NewHandle, InCharacterSet);
 
 		return NewHandle;
 	}
@@ -173,42 +517,80 @@ FPendingCharacterRecipeHandle FActiveCharacterRecipeContainer::AddPendingCharact
 
 void FActiveCharacterRecipeContainer::RemovePendingCharacterRecipe(const FPendingCharacterRecipeHandle& Handle)
 {
-	PendingRecipeMap.Remove(Handle);
+	const auto Index{ PendingRecipes.IndexOfByPredicate([&Handle](const FPendingCharacterRecipe& PendingRecipe) { return PendingRecipe.Handle == Handle; }) };
+
+	if (Index != INDEX_NONE)
+	{
+		PendingRecipes.RemoveAt(Index, 1, false);
+	}
 }
 
 void FActiveCharacterRecipeContainer::ClearPendingCharacterRecipes()
 {
-	PendingRecipeMap.Empty();
+	PendingRecipes.Reset();
 }
 
 void FActiveCharacterRecipeContainer::CommitPendingCharacterRecipes()
 {
 	check(Owner);
 
+	BeginTraceRegion();
+
 	const auto bHasAuthority{ Owner->HasAuthority() };
 	const auto bLocallyControlled{ Owner->IsLocallyControlled() };
 	const auto bIsDedicatedServer{ Owner->GetNetMode() == ENetMode::NM_DedicatedServer };
 
-	// Create an ActiveCharacterRecipe based on the CharacterRecipe class registered in PendingRecipeMap
+	if (bHasAuthority)
+	{
+		WarnIfEntryFilteringUnsupported();
+	}
+
+	// Create an ActiveCharacterRecipe based on the CharacterRecipe class registered in PendingRecipes
+
+	Entries.Reserve(Entries.Num() + PendingRecipes.Num());
 
-	for (const auto& KVP : PendingRecipeMap)
+	for (const auto& PendingRecipe : PendingRecipes)
 	{
-		const auto& PendingRecipe{ KVP.Value };
+		// Only the reference of the CharacterSet is replicated and its CharacterRecipes are expanded locally
 
-		if (PendingRecipe)
+		if (PendingRecipe.CharacterSet)
 		{
-			auto& NewActiveRecipe{ Entries.Emplace_GetRef(PendingRecipe) };
+			const auto NewIndex{ Entries.Emplace(PendingRecipe.CharacterSet.Get()) };
+
+			MarkItemDirty(Entries[NewIndex]);
+
+			RegisterEntry(FActiveCharacterRecipeLocation(NewIndex, false));
+
+			ExpandCharacterSetEntry(NewIndex, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
+		}
+		// Placeholder of a class not loaded on this machine is only replicated
+
+		else if (PendingRecipe.PlaceholderClassPath.IsValid())
+		{
+			const auto NewIndex{ Entries.Emplace(PendingRecipe.PlaceholderClassPath) };
+
+			MarkItemDirty(Entries[NewIndex]);
+
+			RegisterEntry(FActiveCharacterRecipeLocation(NewIndex, false));
+		}
+		else if (PendingRecipe.RecipeClass)
+		{
+			const auto NewIndex{ Entries.Emplace(TSubclassOf<UCharacterRecipe>(PendingRecipe.RecipeClass.Get())) };
+
+			auto& NewActiveRecipe{ Entries[NewIndex] };
 			NewActiveRecipe.HandleCharacterRecipeComitted(Owner, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
 
+			RegisterEntry(FActiveCharacterRecipeLocation(NewIndex, false));
+
 			MarkItemDirty(NewActiveRecipe);
 		}
 		else
 		{
-			UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Invalid CharacterRecipe class was registered in PendingRecipeMap"));
+			UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Invalid CharacterRecipe class was registered in PendingRecipes"));
 		}
 	}
 
-	PendingRecipeMap.Empty();
+	PendingRecipes.Reset();
 
 	// To cause a replicate event even if there is no CharacterRecipe
 
@@ -220,45 +602,560 @@ void FActiveCharacterRecipeContainer::ExecuteCharacterRecipeSetup()
 	check(Owner);
 	check(OwnerComponent);
 
-	const auto bHasAuthority{ Owner->HasAuthority() };
-	const auto bLocallyControlled{ Owner->IsLocallyControlled() };
-	const auto bIsDedicatedServer{ Owner->GetNetMode() == ENetMode::NM_DedicatedServer };
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_ExecuteRecipeSetup);
 
-	for (auto& Entry : Entries)
-	{
-		Entry.TryExecuteSetup(Owner, OwnerComponent, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
-	}
-}
+	BeginTraceRegion();
 
-void FActiveCharacterRecipeContainer::AddActiveRecipeHandlePendingFinish(const FActiveCharacterRecipeHandle& InHandle)
-{
-	RecipesPendingFinish.Add(InHandle);
-}
+	TArray<FActiveCharacterRecipe*, TInlineAllocator<NumInlinePendingRecipes>> OrderedEntries;
+	GatherRecipeEntriesInExecutionOrder(OrderedEntries);
+
+	BuildDependencyGraph(OrderedEntries);
+
+	AssignBuildCacheKeys(OrderedEntries);
+
+	// Start entries without unfinished prerequisites in the order of commit, the others are started when their prerequisites finish.
+	// The baked settings of a CharacterSet are applied at its position, as they replace the leading CharacterRecipes of the CharacterSet.
+
+	const auto TryStartEntry
+	{
+		[this](FActiveCharacterRecipe& Entry)
+		{
+			if (Entry.RecipeCDO && !Entry.bFinished && !Entry.bSetupStarted && !Entry.bSetupDeferred && (Entry.NumUnfinishedPrerequisites <= 0))
+			{
+				ExecuteEntrySetup(Entry);
+			}
+		}
+	};
 
-void FActiveCharacterRecipeContainer::MarkActiveRecipeHandlePendingFinish()
-{
 	for (auto& Entry : Entries)
 	{
-		if (RecipesPendingFinish.Contains(Entry.Handle))
+		if (Entry.IsCharacterSetEntry())
 		{
-			Entry.MarkFinished();
+			ApplyBakedSettings(Entry);
+
+			for (auto ExpandedIndex{ Entry.ExpandedEntriesBegin }; ExpandedIndex < Entry.ExpandedEntriesBegin + Entry.NumExpandedEntries; ++ExpandedIndex)
+			{
+				TryStartEntry(ExpandedEntries[ExpandedIndex]);
+			}
+		}
+		else
+		{
+			TryStartEntry(Entry);
 		}
 	}
 
-	RecipesPendingFinish.Empty();
+	// Commit mesh changes of the baked settings and the CharacterRecipes finished synchronously in one pass
+
+	CommitStagedMeshChanges();
+
+	CheckAllRecipesFinished();
 }
 
-void FActiveCharacterRecipeContainer::ReleaseCharacterRecipes()
+void FActiveCharacterRecipeContainer::ExecuteEntrySetup(FActiveCharacterRecipe& Entry)
 {
-	Entries.Empty();
-	PendingRecipeMap.Empty();
-	RecipesPendingFinish.Empty();
+	// Defer cosmetic CharacterRecipes of pawns that are not significant
 
-	for (auto& Entry : Entries)
+	if (auto* Subsystem{ UWorld::GetSubsystem<UCharacterRecipeSubsystem>(Owner->GetWorld()) })
 	{
-		Entry.NotifyDestroy();
+		if (Subsystem->ShouldDeferCosmeticRecipes(Owner) && CanDeferEntry(Entry))
+		{
+			DeferEntry(Entry);
+
+			Subsystem->RegisterDeferredRecipes(OwnerComponent);
+			return;
+		}
+	}
+
+	Entry.bSetupStarted = true;
+
+	// Queue to the subsystem to spread the setup process of all pawns across frames
+
+	if (UCharacterRecipeSubsystem::IsSetupTimeSlicingEnabled())
+	{
+		if (auto* Subsystem{ UWorld::GetSubsystem<UCharacterRecipeSubsystem>(Owner->GetWorld()) })
+		{
+			Subsystem->QueueRecipeSetup(OwnerComponent, Entry.Handle, Owner->IsLocallyControlled());
+			return;
+		}
+	}
+
+	ExecuteEntrySetupImmediately(Entry);
+}
+
+void FActiveCharacterRecipeContainer::ExecuteEntrySetupImmediately(FActiveCharacterRecipe& Entry)
+{
+	const auto bHasAuthority{ Owner->HasAuthority() };
+	const auto bLocallyControlled{ Owner->IsLocallyControlled() };
+	const auto bIsDedicatedServer{ Owner->GetNetMode() == ENetMode::NM_DedicatedServer };
+
+	// Commit the mesh changes of the preceding CharacterRecipes so that this CharacterRecipe sees their results
+
+	if (Entry.RecipeCDO && !Entry.RecipeCDO->CanStartWithStagedMeshChanges())
+	{
+		CommitStagedMeshChanges();
+	}
+
+	// Mark as finished if not needed to run in the current environment
+
+	if (!Entry.TryExecuteSetup(Owner, OwnerComponent, bHasAuthority, bLocallyControlled, bIsDedicatedServer))
+	{
+		MarkEntryFinished(Entry);
+	}
+}
+
+void FActiveCharacterRecipeContainer::ApplyBakedSettings(FActiveCharacterRecipe& Entry)
+{
+	if (Entry.IsCharacterSetExpanded() && !Entry.bBakedSettingsApplied)
+	{
+		Entry.bBakedSettingsApplied = true;
+
+		if (Entry.CharacterSet->HasBakedSettings())
+		{
+			Entry.CharacterSet->ApplyBakedSettings(FCharacterRecipePawnInfo(Entry.Handle, Owner, OwnerComponent));
+		}
+	}
+}
+
+void FActiveCharacterRecipeContainer::GatherRecipeEntriesInExecutionOrder(TArray<FActiveCharacterRecipe*, TInlineAllocator<NumInlinePendingRecipes>>& OutEntries)
+{
+	OutEntries.Reset();
+
+	// The CharacterRecipes expanded from a CharacterSet are placed at the position of the CharacterSet
+
+	for (auto& Entry : Entries)
+	{
+		if (Entry.IsCharacterSetEntry())
+		{
+			for (auto ExpandedIndex{ Entry.ExpandedEntriesBegin }; ExpandedIndex < Entry.ExpandedEntriesBegin + Entry.NumExpandedEntries; ++ExpandedIndex)
+			{
+				auto& ExpandedEntry{ ExpandedEntries[ExpandedIndex] };
+
+				if (ExpandedEntry.RecipeCDO && !ExpandedEntry.bFinished)
+				{
+					OutEntries.Emplace(&ExpandedEntry);
+				}
+			}
+		}
+		else if (Entry.RecipeCDO && !Entry.bFinished)
+		{
+			OutEntries.Emplace(&Entry);
+		}
+	}
+}
+
+/**
+ * Returns true only the first time a problem with the prerequisite of the CharacterRecipe class is reported
+ *
+ * Tips:
+ *	The same CharacterRecipes are committed to many pawns, so each problem is reported once per process.
+ *	CharacterSets are validated for circular dependencies in IsDataValid().
+ */
+static bool ShouldReportPrerequisiteProblem(const UClass* RecipeClass, FName Prerequisite)
+{
+	static TSet<uint32> ReportedProblems;
+
+	auto bAlreadyReported{ false };
+	ReportedProblems.Add(HashCombine(GetTypeHash(RecipeClass), GetTypeHash(Prerequisite)), &bAlreadyReported);
+
+	return !bAlreadyReported;
+}
+
+void FActiveCharacterRecipeContainer::BuildDependencyGraph(TConstArrayView<FActiveCharacterRecipe*> OrderedEntries)
+{
+	const auto NumEntries{ OrderedEntries.Num() };
+
+	const auto bHasAuthority{ Owner->HasAuthority() };
+	const auto bLocallyControlled{ Owner->IsLocallyControlled() };
+	const auto bIsDedicatedServer{ Owner->GetNetMode() == ENetMode::NM_DedicatedServer };
+
+	TArray<TArray<int32, TInlineAllocator<4>>, TInlineAllocator<NumInlinePendingRecipes>> DependentIndices;
+	TArray<int32, TInlineAllocator<NumInlinePendingRecipes>> NumPrerequisites;
+
+	DependentIndices.SetNum(NumEntries);
+	NumPrerequisites.SetNumZeroed(NumEntries);
+
+	auto bHasAnyPrerequisites{ false };
+
+	// CharacterRecipes baked into a committed CharacterSet are not added as entries, but their settings are applied
+
+	const auto IsBakedInCommittedSet
+	{
+		[this](TFunctionRef<bool(const UCharacterSet&)> Predicate)
+		{
+			return Entries.ContainsByPredicate([&Predicate](const FActiveCharacterRecipe& Entry) { return Entry.CharacterSet && Predicate(*Entry.CharacterSet); });
+		}
+	};
+
+	// Resolve prerequisites of each entry to the entries that satisfy them
+
+	for (auto Index{ 0 }; Index < NumEntries; ++Index)
+	{
+		const auto* RecipeCDO{ OrderedEntries[Index]->RecipeCDO.Get() };
+
+		if (!RecipeCDO->HasPrerequisites())
+		{
+			continue;
+		}
+
+		bHasAnyPrerequisites = true;
+
+		auto AddEdge
+		{
+			[&](int32 PrerequisiteIndex)
+			{
+				if (PrerequisiteIndex != Index && !DependentIndices[PrerequisiteIndex].Contains(Index))
+				{
+					DependentIndices[PrerequisiteIndex].Emplace(Index);
+					++NumPrerequisites[Index];
+				}
+			}
+		};
+
+		for (const auto& PrerequisiteSoftClass : RecipeCDO->GetPrerequisiteRecipeClasses())
+		{
+			// A class not loaded cannot be committed.
+			// This is expected on dedicated servers where ClientOnly CharacterRecipes are stripped from the cook.
+
+			const auto* PrerequisiteClass{ PrerequisiteSoftClass.Get() };
+
+			if (!PrerequisiteClass)
+			{
+				if (!PrerequisiteSoftClass.IsNull())
+				{
+					if (Owner->GetNetMode() == ENetMode::NM_DedicatedServer)
+					{
+						UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("%s | Prerequisite CharacterRecipe class (%s) is not loaded, ignored")
+							, *OrderedEntries[Index]->GetDebugString(), *PrerequisiteSoftClass.ToString());
+					}
+					else if (ShouldReportPrerequisiteProblem(RecipeCDO->GetClass(), FName(PrerequisiteSoftClass.ToString())))
+					{
+						UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("%s | Prerequisite CharacterRecipe class (%s) is not loaded and cannot be committed, ignored")
+							, *OrderedEntries[Index]->GetDebugString(), *PrerequisiteSoftClass.ToString());
+					}
+				}
+
+				continue;
+			}
+
+			auto bFound{ false };
+
+			for (auto OtherIndex{ 0 }; OtherIndex < NumEntries; ++OtherIndex)
+			{
+				if ((OtherIndex != Index) && OrderedEntries[OtherIndex]->RecipeCDO->GetClass()->IsChildOf(PrerequisiteClass))
+				{
+					AddEdge(OtherIndex);
+					bFound = true;
+				}
+			}
+
+			// A prerequisite not executed on this machine by its NetExecutionPolicy is not replicated here either, and is satisfied
+
+			if (!bFound)
+			{
+				if (IsBakedInCommittedSet([PrerequisiteClass](const UCharacterSet& Set) { return Set.HasBakedRecipeClass(PrerequisiteClass); }))
+				{
+					UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("%s | Prerequisite CharacterRecipe class (%s) is baked into a CharacterSet, satisfied")
+						, *OrderedEntries[Index]->GetDebugString(), *GetNameSafe(PrerequisiteClass));
+				}
+				else if (!GetDefault<UCharacterRecipe>(PrerequisiteClass)->ShouldExecuteOn(bHasAuthority, bLocallyControlled, bIsDedicatedServer))
+				{
+					UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("%s | Prerequisite CharacterRecipe class (%s) is not executed on this machine, satisfied")
+						, *OrderedEntries[Index]->GetDebugString(), *GetNameSafe(PrerequisiteClass));
+				}
+				else if (ShouldReportPrerequisiteProblem(RecipeCDO->GetClass(), PrerequisiteClass->GetFName()))
+				{
+					UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("%s | Prerequisite CharacterRecipe class (%s) is not committed, ignored")
+						, *OrderedEntries[Index]->GetDebugString(), *GetNameSafe(PrerequisiteClass));
+				}
+			}
+		}
+
+		for (const auto& PrerequisiteTag : RecipeCDO->GetPrerequisiteRecipeTags())
+		{
+			auto bFound{ false };
+
+			for (auto OtherIndex{ 0 }; OtherIndex < NumEntries; ++OtherIndex)
+			{
+				if ((OtherIndex != Index) && OrderedEntries[OtherIndex]->RecipeCDO->GetRecipeTags().HasTag(PrerequisiteTag))
+				{
+					AddEdge(OtherIndex);
+					bFound = true;
+				}
+			}
+
+			if (!bFound && !IsBakedInCommittedSet([&PrerequisiteTag](const UCharacterSet& Set) { return Set.HasBakedRecipeTag(PrerequisiteTag); })
+				&& ShouldReportPrerequisiteProblem(RecipeCDO->GetClass(), PrerequisiteTag.GetTagName()))
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("%s | No committed CharacterRecipe has prerequisite tag (%s), ignored")
+					, *OrderedEntries[Index]->GetDebugString(), *PrerequisiteTag.ToString());
+			}
+		}
+	}
+
+	if (!bHasAnyPrerequisites)
+	{
+		return;
+	}
+
+	// Find cycles by topological sort and break them by ignoring the prerequisites of the entries in the cycles
+
+	auto RemainingPrerequisites{ NumPrerequisites };
+
+	TArray<int32, TInlineAllocator<NumInlinePendingRecipes>> ReadyIndices;
+
+	for (auto Index{ 0 }; Index < NumEntries; ++Index)
+	{
+		if (RemainingPrerequisites[Index] == 0)
+		{
+			ReadyIndices.Emplace(Index);
+		}
+	}
+
+	for (auto ReadyIt{ 0 }; ReadyIt < ReadyIndices.Num(); ++ReadyIt)
+	{
+		for (const auto& DependentIndex : DependentIndices[ReadyIndices[ReadyIt]])
+		{
+			if (--RemainingPrerequisites[DependentIndex] == 0)
+			{
+				ReadyIndices.Emplace(DependentIndex);
+			}
+		}
+	}
+
+	if (ReadyIndices.Num() < NumEntries)
+	{
+		for (auto Index{ 0 }; Index < NumEntries; ++Index)
+		{
+			if (RemainingPrerequisites[Index] > 0)
+			{
+				static const FName NAME_CircularDependency{ TEXTVIEW("CircularDependency") };
+
+				if (ShouldReportPrerequisiteProblem(OrderedEntries[Index]->RecipeCDO->GetClass(), NAME_CircularDependency))
+				{
+					UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("%s | Part of or depends on a circular dependency between CharacterRecipes, prerequisites are ignored")
+						, *OrderedEntries[Index]->GetDebugString());
+				}
+
+				NumPrerequisites[Index] = 0;
+			}
+		}
+	}
+
+	// Apply the graph to the entries
+
+	for (auto Index{ 0 }; Index < NumEntries; ++Index)
+	{
+		auto& Entry{ *OrderedEntries[Index] };
+
+		Entry.NumUnfinishedPrerequisites = NumPrerequisites[Index];
+		Entry.DependentHandles.Reset();
+
+		for (const auto& DependentIndex : DependentIndices[Index])
+		{
+			Entry.DependentHandles.Emplace(OrderedEntries[DependentIndex]->Handle);
+		}
+	}
+}
+
+bool FActiveCharacterRecipeContainer::CanDeferEntry(const FActiveCharacterRecipe& Entry, int32 Depth)
+{
+	// Guard against cycles that were broken when building the dependency graph
+
+	if (Depth > Entries.Num() + ExpandedEntries.Num())
+	{
+		return false;
+	}
+
+	if (!Entry.RecipeCDO || (Entry.RecipeCDO->GetNetExecutionPolicy() != ECharacterRecipeNetExecutionPolicy::ClientOnly))
+	{
+		return false;
+	}
+
+	// Entries that other entries depend on can be deferred only if all of them can be deferred as well
+
+	for (const auto& DependentHandle : Entry.DependentHandles)
+	{
+		if (const auto* DependentEntry{ FindEntry(DependentHandle) })
+		{
+			if (!DependentEntry->bSetupDeferred && !CanDeferEntry(*DependentEntry, Depth + 1))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void FActiveCharacterRecipeContainer::DeferEntry(FActiveCharacterRecipe& Entry)
+{
+	if (Entry.bSetupDeferred || Entry.bSetupStarted || Entry.bFinished)
+	{
+		return;
+	}
+
+	Entry.bSetupDeferred = true;
+
+	--NumUnfinishedRecipes;
+	++NumDeferredRecipes;
+
+	UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("%s | Deferred until the pawn becomes significant"), *Entry.GetDebugString());
+
+	for (const auto& DependentHandle : Entry.DependentHandles)
+	{
+		if (auto* DependentEntry{ FindEntry(DependentHandle) })
+		{
+			DeferEntry(*DependentEntry);
+		}
+	}
+}
+
+void FActiveCharacterRecipeContainer::ResumeDeferredRecipes()
+{
+	if (NumDeferredRecipes <= 0)
+	{
+		return;
+	}
+
+	TArray<FActiveCharacterRecipe*, TInlineAllocator<NumInlinePendingRecipes>> OrderedEntries;
+	GatherRecipeEntriesInExecutionOrder(OrderedEntries);
+
+	// Count the deferred entries as unfinished again before starting any of them
+
+	for (auto* Entry : OrderedEntries)
+	{
+		if (Entry->bSetupDeferred)
+		{
+			Entry->bSetupDeferred = false;
+
+			++NumUnfinishedRecipes;
+		}
 	}
 
+	NumDeferredRecipes = 0;
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("[CLIENT] Resume deferred CharacterRecipes"));
+
+	for (auto* Entry : OrderedEntries)
+	{
+		if (!Entry->bSetupStarted && !Entry->bSetupDeferred && (Entry->NumUnfinishedPrerequisites <= 0))
+		{
+			ExecuteEntrySetup(*Entry);
+		}
+	}
+
+	// Commit the meshes staged by the resumed entries and finish the setup if they all finished synchronously
+
+	CommitStagedMeshChanges();
+
+	CheckAllRecipesFinished();
+}
+
+void FActiveCharacterRecipeContainer::StartDependentEntries(const FActiveCharacterRecipe& Entry)
+{
+	for (const auto& DependentHandle : Entry.DependentHandles)
+	{
+		if (auto* DependentEntry{ FindEntry(DependentHandle) })
+		{
+			if (--DependentEntry->NumUnfinishedPrerequisites <= 0 && !DependentEntry->bSetupStarted && !DependentEntry->bSetupDeferred && !DependentEntry->bFinished)
+			{
+				ExecuteEntrySetup(*DependentEntry);
+			}
+		}
+	}
+}
+
+void FActiveCharacterRecipeContainer::ExecuteQueuedEntrySetup(const FActiveCharacterRecipeHandle& InHandle)
+{
+	// Entry may have been released while waiting in the queue
+
+	if (auto* Entry{ FindEntry(InHandle) })
+	{
+		if (!Entry->bFinished)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_GCExt_ExecuteRecipeSetup);
+
+			ExecuteEntrySetupImmediately(*Entry);
+
+			CommitStagedMeshChanges();
+
+			CheckAllRecipesFinished();
+		}
+	}
+}
+
+void FActiveCharacterRecipeContainer::AddActiveRecipeHandlePendingFinish(const FActiveCharacterRecipeHandle& InHandle)
+{
+	RecipesPendingFinish.AddUnique(InHandle);
+}
+
+void FActiveCharacterRecipeContainer::MarkActiveRecipeHandlePendingFinish()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_ProcessFinishedRecipes);
+
+	// Commit mesh changes before the entries waiting for the finished entries start
+
+	CommitStagedMeshChanges();
+
+	for (const auto& PendingHandle : RecipesPendingFinish)
+	{
+		if (auto* Entry{ FindEntry(PendingHandle) })
+		{
+			if (Entry->bStoreBuildOutput && !Entry->bFinished)
+			{
+				StoreEntryBuildOutput(*Entry);
+			}
+
+			MarkEntryFinished(*Entry);
+		}
+	}
+
+	RecipesPendingFinish.Reset();
+
+	CheckAllRecipesFinished();
+}
+
+void FActiveCharacterRecipeContainer::StageMeshChanges(TConstArrayView<FMeshToSetMesh> InMeshesToSetMesh)
+{
+	StagedMeshChanges.Stage(InMeshesToSetMesh);
+}
+
+void FActiveCharacterRecipeContainer::CommitStagedMeshChanges()
+{
+	if (!StagedMeshChanges.IsEmpty())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_GCExt_CommitStagedMeshChanges);
+
+		StagedMeshChanges.Commit(Owner, OwnerComponent);
+	}
+}
+
+void FActiveCharacterRecipeContainer::ReleaseCharacterRecipes()
+{
+	for (auto& Entry : Entries)
+	{
+		EndEntryTraceRegion(Entry);
+		Entry.NotifyDestroy();
+	}
+
+	for (auto& Entry : ExpandedEntries)
+	{
+		EndEntryTraceRegion(Entry);
+		Entry.NotifyDestroy();
+	}
+
+	EndTraceRegion();
+
+	Entries.Empty();
+	ExpandedEntries.Empty();
+	PendingRecipes.Empty();
+	RecipesPendingFinish.Empty();
+	EntryIndexMap.Empty();
+	bEntryIndexMapDirty = false;
+	NumUnfinishedRecipes = 0;
+	NumDeferredRecipes = 0;
+	StagedMeshChanges.Reset();
+
 	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("[%s] All CharacterRecipes Released"), Owner->HasAuthority() ? TEXT("SERVER") : TEXT("CLIENT"));
 
 	/**
@@ -269,22 +1166,216 @@ void FActiveCharacterRecipeContainer::ReleaseCharacterRecipes()
 }
 
 
-ECharacterRecipesApplicationState FActiveCharacterRecipeContainer::GetCurrentApplicationState() const
+void FActiveCharacterRecipeContainer::RegisterEntry(const FActiveCharacterRecipeLocation& Location)
 {
-	if (ApplicationState == ECharacterRecipesApplicationState::Commited)
+	const auto& Entry{ GetEntryAt(Location) };
+
+	EntryIndexMap.Add(Entry.Handle, Location);
+
+	if (!Entry.bFinished)
 	{
-		for (const auto& Entry : Entries)
+		++NumUnfinishedRecipes;
+	}
+}
+
+void FActiveCharacterRecipeContainer::ExpandCharacterSetEntry(int32 Index, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer)
+{
+	const auto& RecipeClasses{ Entries[Index].CharacterSet->GetCharacterRecipes() };
+
+	const auto ExpandedEntriesBegin{ ExpandedEntries.Num() };
+
+	ExpandedEntries.Reserve(ExpandedEntriesBegin + RecipeClasses.Num());
+
+	for (const auto& RecipeClass : RecipeClasses)
+	{
+		if (RecipeClass)
 		{
-			if (!Entry.bFinished)
-			{
-				return ApplicationState;
-			}
+			const auto NewIndex{ ExpandedEntries.Emplace(RecipeClass) };
+
+			ExpandedEntries[NewIndex].HandleCharacterRecipeComitted(Owner, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
+
+			RegisterEntry(FActiveCharacterRecipeLocation(NewIndex, true));
+		}
+	}
+
+	auto& Entry{ Entries[Index] };
+	Entry.ExpandedEntriesBegin = ExpandedEntriesBegin;
+	Entry.NumExpandedEntries = ExpandedEntries.Num() - ExpandedEntriesBegin;
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("[%s] Expanded: %s")
+		, bHasAuthority ? TEXT("SERVER") : TEXT("CLIENT")
+		, *Entry.GetDebugString());
+}
+
+bool FActiveCharacterRecipeContainer::TryExpandReplicatedCharacterSetEntry(int32 Index, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer)
+{
+	auto& Entry{ Entries[Index] };
+
+	// The reference may not be mapped yet (e.g. the CharacterSet is still loading on the client).
+	// The entry stays unfinished until it is mapped and expanded in PostReplicatedChange() so that the InitState does not proceed without it.
+
+	if (!Entry.CharacterSet)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("[CLIENT] CharacterSet of [%s] is not mapped yet, expansion is deferred"), *Entry.Handle.ToString());
+		return false;
+	}
+
+	if (Entry.MarkFinished())
+	{
+		--NumUnfinishedRecipes;
+	}
+
+	ExpandCharacterSetEntry(Index, bHasAuthority, bLocallyControlled, bIsDedicatedServer);
+
+	return true;
+}
+
+void FActiveCharacterRecipeContainer::AssignBuildCacheKeys(TConstArrayView<FActiveCharacterRecipe*> OrderedEntries)
+{
+	if (!UCharacterRecipeBuildCache::IsBuildCacheEnabled())
+	{
+		return;
+	}
+
+	// The hash covers all CharacterRecipes in the order of execution, since the output of a CharacterRecipe may depend on the preceding ones
+
+	// The full list is kept in the signature, so that an output found by hash is only applied to the same build
+
+	auto NewSignature{ MakeShared<FCharacterRecipeBuildSignature>() };
+	NewSignature->RecipeClasses.Reserve(OrderedEntries.Num());
+	NewSignature->ParameterHashes.Reserve(OrderedEntries.Num());
+	NewSignature->Hash = static_cast<uint32>(OrderedEntries.Num());
+
+	auto bAnyEntryCachesOutput{ false };
+
+	for (const auto* Entry : OrderedEntries)
+	{
+		auto PawnInfo{ FCharacterRecipePawnInfo(Entry->Handle, Owner, OwnerComponent) };
+
+		const auto* RecipeClass{ Entry->RecipeCDO->GetClass() };
+		const auto ParameterHash{ Entry->RecipeCDO->GetBuildParameterHash(PawnInfo) };
+
+		NewSignature->RecipeClasses.Emplace(RecipeClass);
+		NewSignature->ParameterHashes.Emplace(ParameterHash);
+		NewSignature->Hash = HashCombine(NewSignature->Hash, GetTypeHash(RecipeClass));
+		NewSignature->Hash = HashCombine(NewSignature->Hash, ParameterHash);
+
+		bAnyEntryCachesOutput |= (!Entry->bSetupStarted && Entry->RecipeCDO->IsBuildOutputCacheEnabled());
+	}
+
+	BuildHash = NewSignature->Hash;
+
+	if (!bAnyEntryCachesOutput)
+	{
+		return;
+	}
+
+	const TSharedRef<const FCharacterRecipeBuildSignature> Signature{ MoveTemp(NewSignature) };
+
+	for (auto Index{ 0 }; Index < OrderedEntries.Num(); ++Index)
+	{
+		auto* Entry{ OrderedEntries[Index] };
+
+		if (Entry->bSetupStarted || !Entry->RecipeCDO->IsBuildOutputCacheEnabled())
+		{
+			continue;
 		}
 
+		Entry->BuildCacheKey = FCharacterRecipeBuildCacheKey(Signature, Index);
+	}
+}
+
+void FActiveCharacterRecipeContainer::StoreEntryBuildOutput(FActiveCharacterRecipe& Entry)
+{
+	Entry.bStoreBuildOutput = false;
+
+	auto* BuildCache{ UWorld::GetSubsystem<UCharacterRecipeBuildCache>(Owner->GetWorld()) };
+
+	if (!BuildCache || !Entry.RecipeCDO)
+	{
+		return;
+	}
+
+	// The output is created by the object that executed the setup process
+
+	const UCharacterRecipe* Recipe{ Entry.RecipeInstance ? Entry.RecipeInstance.Get() : Entry.RecipeCDO.Get() };
+
+	auto PawnInfo{ FCharacterRecipePawnInfo(Entry.Handle, Owner, OwnerComponent) };
+
+	if (auto* BuildOutput{ Recipe->CreateBuildOutput(BuildCache, PawnInfo) })
+	{
+		BuildCache->StoreBuildOutput(Entry.BuildCacheKey, BuildOutput);
+	}
+}
+
+void FActiveCharacterRecipeContainer::MarkEntryFinished(FActiveCharacterRecipe& Entry)
+{
+	if (Entry.MarkFinished())
+	{
+		--NumUnfinishedRecipes;
+
+		EndEntryTraceRegion(Entry);
+
+		StartDependentEntries(Entry);
+	}
+}
+
+void FActiveCharacterRecipeContainer::CheckAllRecipesFinished()
+{
+	if ((ApplicationState == ECharacterRecipesApplicationState::Commited) && (NumUnfinishedRecipes <= 0))
+	{
 		ApplicationState = ECharacterRecipesApplicationState::Complete;
+
+		EndTraceRegion();
+
+		if (OwnerComponent)
+		{
+			OwnerComponent->HandleAllRecipesFinished();
+		}
+	}
+}
+
+void FActiveCharacterRecipeContainer::BeginTraceRegion()
+{
+	if (TraceRegionName.IsEmpty())
+	{
+		TraceRegionName = GCExtStats::BeginPawnRegion(Owner);
 	}
+}
+
+void FActiveCharacterRecipeContainer::EndTraceRegion()
+{
+	GCExtStats::EndRegion(TraceRegionName);
+}
+
+void FActiveCharacterRecipeContainer::EndEntryTraceRegion(FActiveCharacterRecipe& Entry)
+{
+	GCExtStats::EndRegion(Entry.TraceRegionName);
+}
+
+
+FActiveCharacterRecipe* FActiveCharacterRecipeContainer::FindEntry(const FActiveCharacterRecipeHandle& InHandle)
+{
+	if (bEntryIndexMapDirty)
+	{
+		EntryIndexMap.Reset();
+
+		for (auto Index{ 0 }; Index < Entries.Num(); ++Index)
+		{
+			EntryIndexMap.Add(Entries[Index].Handle, FActiveCharacterRecipeLocation(Index, false));
+		}
+
+		for (auto Index{ 0 }; Index < ExpandedEntries.Num(); ++Index)
+		{
+			EntryIndexMap.Add(ExpandedEntries[Index].Handle, FActiveCharacterRecipeLocation(Index, true));
+		}
+
+		bEntryIndexMapDirty = false;
+	}
+
+	const auto* Location{ EntryIndexMap.Find(InHandle) };
 
-	return ApplicationState;
+	return Location ? &GetEntryAt(*Location) : nullptr;
 }
 
 #pragma endregion
@@ -6,11 +6,15 @@
 
 #include "Recipe/ActiveCharacterRecipeHandle.h"
 #include "Recipe/PendingCharacterRecipeHandle.h"
+#include "Recipe/CharacterRecipeRegistry.h"
+#include "Recipe/CharacterRecipeBuildCache.h"
+#include "Recipe/CharacterSetMeshTypes.h"
 
 #include "ActiveCharacterRecipe.generated.h"
 
 class APawn;
 class UCharacterRecipe;
+class UCharacterSet;
 class UCharacterInitStateComponent;
 
 
@@ -54,6 +58,16 @@ public:
 	 */
 	FActiveCharacterRecipe(const UCharacterRecipe* InCDO);
 
+	/** 
+	 * Version that takes an CharacterSet
+	 */
+	FActiveCharacterRecipe(const UCharacterSet* InCharacterSet);
+
+	/** 
+	 * Version that takes a path of the CharacterRecipe class not loaded on this machine
+	 */
+	FActiveCharacterRecipe(const FSoftClassPath& InPlaceholderClassPath);
+
 
 protected:
 	//
@@ -62,15 +76,60 @@ protected:
 	UPROPERTY()
 	FActiveCharacterRecipeHandle Handle;
 
+	//
+	// Index of the CharacterRecipe class in CharacterRecipeRegistry
+	// 
+	// Tips:
+	//	Replicated instead of RecipeCDO and resolved to RecipeCDO on the client.
+	//
+	UPROPERTY()
+	FCharacterRecipeClassIndex RecipeClassIndex;
+
+	//
+	// Path of the CharacterRecipe class
+	// 
+	// Tips:
+	//	Only set if the class has no index in CharacterRecipeRegistry, and replicated instead of RecipeClassIndex.
+	//
+	UPROPERTY()
+	FSoftClassPath RecipeClassPath;
+
 	//
 	// CDO of the CharacterRecipe
 	// 
 	// Tips:
 	//	If InstancingPolicy is "NonInstanced", this CDO is used for processing.
+	//	Not replicated, it is resolved from RecipeClassIndex or RecipeClassPath.
 	//
-	UPROPERTY()
+	UPROPERTY(NotReplicated)
 	TObjectPtr<const UCharacterRecipe> RecipeCDO{ nullptr };
 
+	//
+	// CharacterSet to be expanded into CharacterRecipes
+	// 
+	// Tips:
+	//	If set, this entry has no CharacterRecipe of its own and is treated as finished.
+	//	The CharacterRecipes of the CharacterSet are expanded locally on both server and client in the same order,
+	//	so only this reference is replicated instead of an entry for each CharacterRecipe.
+	//
+	UPROPERTY()
+	TObjectPtr<const UCharacterSet> CharacterSet{ nullptr };
+
+	//
+	// Index of the first entry expanded from CharacterSet in ExpandedEntries of the container
+	//
+	int32 ExpandedEntriesBegin{ INDEX_NONE };
+
+	//
+	// Number of entries expanded from CharacterSet
+	//
+	int32 NumExpandedEntries{ 0 };
+
+	//
+	// Whether the settings baked into CharacterSet have been applied
+	//
+	bool bBakedSettingsApplied{ false };
+
 	//
 	// Instanced of the CharacterRecipe
 	// 
@@ -86,7 +145,67 @@ protected:
 	UPROPERTY(NotReplicated)
 	bool bFinished{ false };
 
+	//
+	// Whether the setup process has been started
+	//
+	bool bSetupStarted{ false };
+
+	//
+	// Whether the setup process is deferred because the pawn is not significant
+	// 
+	// Tips:
+	//	Deferred entries are treated as finished for the application state.
+	//
+	bool bSetupDeferred{ false };
+
+	//
+	// Number of prerequisite entries that have not finished yet
+	// 
+	// Tips:
+	//	The setup process starts when this becomes 0.
+	//
+	int32 NumUnfinishedPrerequisites{ 0 };
+
+	//
+	// Handles of the entries waiting for this entry to finish
+	//
+	TArray<FActiveCharacterRecipeHandle, TInlineAllocator<4>> DependentHandles;
+
+	//
+	// Key of the output of this entry in CharacterRecipeBuildCache
+	// 
+	// Tips:
+	//	Not assigned if the CharacterRecipe does not cache its output.
+	//
+	FCharacterRecipeBuildCacheKey BuildCacheKey;
+
+	//
+	// Whether the output of this entry is stored in CharacterRecipeBuildCache when the setup process is finished
+	//
+	bool bStoreBuildOutput{ false };
+
+	//
+	// Name of the trace region of the setup of this entry, empty if the region has not begun
+	//
+	FString TraceRegionName;
+
 protected:
+	/**
+	 * Set RecipeClassIndex from RecipeCDO
+	 * 
+	 * Tips:
+	 *	If the class has no index, RecipeClassPath is set instead
+	 */
+	void AssignRecipeClassIndex();
+
+	/**
+	 * Resolve RecipeCDO from the replicated RecipeClassIndex or RecipeClassPath
+	 * 
+	 * Tips:
+	 *	Returns false if the class could not be resolved from either
+	 */
+	bool ResolveRecipeCDO();
+
 	/**
 	 * Notify that a CharacterRecipe has been committed and an ActiveCharacterRecipe has been created.
 	 */
@@ -99,20 +218,49 @@ protected:
 
 	/**
 	 * Perform setup process with CharacterRecipe if possible
+	 * 
+	 * Tips:
+	 *	Returns false if the CharacterRecipe does not need to run in the current environment
 	 */
-	void TryExecuteSetup(APawn* Owner, UCharacterInitStateComponent* OwnerComponent, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer);
+	bool TryExecuteSetup(APawn* Owner, UCharacterInitStateComponent* OwnerComponent, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer);
 
 	/**
 	 * Mark as finished
+	 * 
+	 * Tips:
+	 *	Returns true if it was not finished yet
 	 */
-	void MarkFinished();
+	bool MarkFinished();
 
 	/**
 	 * Notify the character to be destroyed.
 	 */
 	void NotifyDestroy();
 
+	/**
+	 * Release RecipeInstance without notifying it, returning it to the pool if it was acquired from it
+	 */
+	void ReleaseRecipeInstance();
+
+	/**
+	 * Returns whether this entry is included in the unfinished count of the container
+	 */
+	bool IsCountedAsUnfinished() const { return !bFinished && !bSetupDeferred; }
+
 public:
+	/**
+	 * Returns whether this entry is expanded from CharacterSet
+	 * 
+	 * Tips:
+	 *	Entries without a CharacterRecipe class are CharacterSet entries even if the reference of CharacterSet is not mapped yet on the client
+	 */
+	bool IsCharacterSetEntry() const { return (CharacterSet != nullptr) || (!RecipeClassIndex.IsValid() && !RecipeClassPath.IsValid()); }
+
+	/**
+	 * Returns whether the CharacterRecipes of CharacterSet have been expanded
+	 */
+	bool IsCharacterSetExpanded() const { return ExpandedEntriesBegin != INDEX_NONE; }
+
 	/**
 	 * Returns debug string of this
 	 */
@@ -121,6 +269,54 @@ public:
 };
 
 
+/**
+ * CharacterRecipe class or CharacterSet waiting to be committed
+ */
+struct FPendingCharacterRecipe
+{
+public:
+	FPendingCharacterRecipe() {}
+	FPendingCharacterRecipe(const FPendingCharacterRecipeHandle& InHandle, UClass* InClass)
+		: Handle(InHandle), RecipeClass(InClass)
+	{}
+	FPendingCharacterRecipe(const FPendingCharacterRecipeHandle& InHandle, const UCharacterSet* InCharacterSet)
+		: Handle(InHandle), CharacterSet(InCharacterSet)
+	{}
+	FPendingCharacterRecipe(const FPendingCharacterRecipeHandle& InHandle, const FSoftClassPath& InPlaceholderClassPath)
+		: Handle(InHandle), PlaceholderClassPath(InPlaceholderClassPath)
+	{}
+
+public:
+	FPendingCharacterRecipeHandle Handle;
+
+	TObjectPtr<UClass> RecipeClass{ nullptr };
+
+	TObjectPtr<const UCharacterSet> CharacterSet{ nullptr };
+
+	FSoftClassPath PlaceholderClassPath;
+
+};
+
+
+/**
+ * Location of an ActiveCharacterRecipe in the container
+ */
+struct FActiveCharacterRecipeLocation
+{
+public:
+	FActiveCharacterRecipeLocation() {}
+	FActiveCharacterRecipeLocation(int32 InIndex, bool bInExpanded)
+		: Index(InIndex), bExpanded(bInExpanded)
+	{}
+
+public:
+	int32 Index{ INDEX_NONE };
+
+	bool bExpanded{ false };
+
+};
+
+
 /**
  * List of ActiveCharacterRecipe
  */
@@ -141,19 +337,65 @@ public:
 	TArray<FActiveCharacterRecipe> Entries;
 
 	//
-	// Mapping List of currently pending CharacterRecipe classes
+	// List of ActiveCharacterRecipes expanded locally from the CharacterSet entries
 	// 
 	// Tips:
-	//	Basically only referenced in environments with Authority
+	//	Not replicated, server and client expand the same CharacterSet in the same order.
 	//
 	UPROPERTY(NotReplicated)
-	TMap<FPendingCharacterRecipeHandle, TSubclassOf<UCharacterRecipe>> PendingRecipeMap;
+	TArray<FActiveCharacterRecipe> ExpandedEntries;
+
+	//
+	// Number of pending CharacterRecipes that can be stored without heap allocation
+	//
+	static constexpr int32 NumInlinePendingRecipes{ 16 };
+
+	//
+	// List of currently pending CharacterRecipe classes
+	// 
+	// Tips:
+	//	Basically only referenced in environments with Authority.
+	//	Kept in the order of addition, which is the order of execution.
+	//	Classes are reported to GC by AddStructReferencedObjects().
+	//
+	TArray<FPendingCharacterRecipe, TInlineAllocator<NumInlinePendingRecipes>> PendingRecipes;
 
 	//
 	// List of ActiveCharacterRecipeHandle pending finish
 	//
-	UPROPERTY(NotReplicated)
-	TSet<FActiveCharacterRecipeHandle> RecipesPendingFinish;
+	TArray<FActiveCharacterRecipeHandle, TInlineAllocator<NumInlinePendingRecipes>> RecipesPendingFinish;
+
+	//
+	// Mapping list of ActiveCharacterRecipeHandle and the location of its entry in Entries or ExpandedEntries
+	// 
+	// Tips:
+	//	Elements and hash buckets are stored inline like the other per pawn lists, so a typical pawn does not allocate.
+	//	Handles are unique across all pawns, so they cannot index a per pawn array directly.
+	//
+	TMap<FActiveCharacterRecipeHandle, FActiveCharacterRecipeLocation, TInlineSetAllocator<NumInlinePendingRecipes>> EntryIndexMap;
+
+	//
+	// Whether EntryIndexMap needs to be rebuilt because Entries were removed by replication
+	//
+	bool bEntryIndexMapDirty{ false };
+
+	//
+	// Number of ActiveCharacterRecipes whose setup process has not finished yet
+	//
+	int32 NumUnfinishedRecipes{ 0 };
+
+	//
+	// Number of ActiveCharacterRecipes whose setup process is deferred
+	//
+	int32 NumDeferredRecipes{ 0 };
+
+	//
+	// Hash of the committed CharacterRecipe list and the parameters of each CharacterRecipe
+	// 
+	// Tips:
+	//	Pawns with the same hash share the outputs in CharacterRecipeBuildCache.
+	//
+	uint32 BuildHash{ 0 };
 
 	//
 	// The owner of this container
@@ -174,18 +416,69 @@ public:
 	//	This value is not replicated, but is updated when the container is pushed and replicated to the client
 	//
 	UPROPERTY(NotReplicated)
-	mutable ECharacterRecipesApplicationState ApplicationState{ ECharacterRecipesApplicationState::PreCommit };
+	ECharacterRecipesApplicationState ApplicationState{ ECharacterRecipesApplicationState::PreCommit };
+
+	//
+	// Whether the container is currently being serialized for the connection that owns the pawn
+	//
+	bool bSerializingForOwner{ false };
+
+	//
+	// Name of the trace region of the CharacterRecipe application of the owner, empty if the region has not begun
+	//
+	FString TraceRegionName;
+
+	//
+	// Mesh changes of CharacterRecipes waiting to be committed at once
+	// 
+	// Tips:
+	//	Committed at the end of each setup pass, before the entries waiting for the finished entries start,
+	//	and before each CharacterRecipe that cannot start with staged mesh changes starts.
+	//
+	UPROPERTY(NotReplicated)
+	FStagedMeshChanges StagedMeshChanges;
 
 public:
 	void PreReplicatedRemove(const TArrayView<int32> RemovedIndices, int32 FinalSize);
 	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
 	void PostReplicatedChange(const TArrayView<int32> ChangedIndices, int32 FinalSize);
 
-	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	/**
+	 * Filter the entries sent to each connection by NetExecutionPolicy of the CharacterRecipe
+	 * 
+	 * Tips:
+	 *	"ServerOnly" entries are never sent and "LocalOnly" entries are sent only to the owner connection.
+	 *	The owner is evaluated when the entry is first sent, so entries are not resent when the owner changes later.
+	 *
+	 * Note:
+	 *	Only effective with the generic replication system. Iris does not call this and sends all entries to all connections,
+	 *	where they are still skipped on execution by NetExecutionPolicy. A warning is logged once when Iris is in use.
+	 */
+	template<typename Type, typename SerializerType>
+	bool ShouldWriteFastArrayItem(const Type& Item, const bool bIsWritingOnClient) const
 	{
-		return FFastArraySerializer::FastArrayDeltaSerialize<FActiveCharacterRecipe, FActiveCharacterRecipeContainer>(Entries, DeltaParms, *this);
+		if (bIsWritingOnClient)
+		{
+			return Item.ReplicationID != INDEX_NONE;
+		}
+
+		return ShouldReplicateEntry(Item);
 	}
 
+protected:
+	bool ShouldReplicateEntry(const FActiveCharacterRecipe& Entry) const;
+
+	/**
+	 * Log once if the entries are replicated with Iris, which does not support the filtering of ShouldWriteFastArrayItem()
+	 */
+	void WarnIfEntryFilteringUnsupported() const;
+
+public:
+
+	void AddStructReferencedObjects(FReferenceCollector& Collector);
+
 
 public:
 	/**
@@ -193,6 +486,22 @@ public:
 	 */
 	FPendingCharacterRecipeHandle AddPendingCharacterRecipe(TSubclassOf<UCharacterRecipe> CharacterRecipe);
 
+	/**
+	 * Add a placeholder of the CharacterRecipe class not loaded on this machine to the Pending list
+	 * 
+	 * Tips:
+	 *	The placeholder is treated as finished and only replicated as an index of CharacterRecipeRegistry (or the class path if it has no index)
+	 */
+	FPendingCharacterRecipeHandle AddPendingStrippedCharacterRecipe(const FSoftClassPath& InClassPath);
+
+	/**
+	 * Add a new CharacterSet to the Pending list
+	 * 
+	 * Tips:
+	 *	Only the reference to the CharacterSet is replicated and its CharacterRecipes are expanded locally
+	 */
+	FPendingCharacterRecipeHandle AddPendingCharacterSet(const UCharacterSet* InCharacterSet);
+
 	/**
 	 * Delete the CharacterRecipe class of the specified handle from the Pending list
 	 */
@@ -213,6 +522,21 @@ public:
 	 */
 	void ExecuteCharacterRecipeSetup();
 
+	/**
+	 * Start the setup process of the deferred entries
+	 */
+	void ResumeDeferredRecipes();
+
+	/**
+	 * Returns whether any entry is deferred
+	 */
+	bool HasDeferredRecipes() const { return NumDeferredRecipes > 0; }
+
+	/**
+	 * Perform setup process of the entry queued in CharacterRecipeSubsystem
+	 */
+	void ExecuteQueuedEntrySetup(const FActiveCharacterRecipeHandle& InHandle);
+
 	/**
 	 * Add a new ActiveCharacterRecipeHandle to the Pending list
 	 */
@@ -228,16 +552,139 @@ public:
 	 */
 	void ReleaseCharacterRecipes();
 
+	/**
+	 * Stage the mesh changes to be committed at once with the changes of other CharacterRecipes
+	 */
+	void StageMeshChanges(TConstArrayView<FMeshToSetMesh> InMeshesToSetMesh);
+
+	/**
+	 * Apply the staged mesh changes to the owner
+	 */
+	void CommitStagedMeshChanges();
+
+protected:
+	/**
+	 * Register the entry at the specified location to EntryIndexMap and the unfinished count
+	 */
+	void RegisterEntry(const FActiveCharacterRecipeLocation& Location);
+
+	/**
+	 * Expand the CharacterRecipes of the CharacterSet entry at the specified index into ExpandedEntries
+	 */
+	void ExpandCharacterSetEntry(int32 Index, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer);
+
+	/**
+	 * Expand the CharacterSet entry replicated from the server if its reference has been mapped
+	 * 
+	 * Tips:
+	 *	Returns false if the reference is not mapped yet
+	 */
+	bool TryExpandReplicatedCharacterSetEntry(int32 Index, bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer);
+
+	/**
+	 * Start setup process of the entry, or queue it in CharacterRecipeSubsystem if the setup process is time-sliced
+	 */
+	void ExecuteEntrySetup(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Perform setup process of the entry and mark as finished if not needed
+	 */
+	void ExecuteEntrySetupImmediately(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Apply the settings baked into the CharacterSet of the entry if they have not been applied yet
+	 */
+	void ApplyBakedSettings(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Returns list of the entries that have CharacterRecipe in the order of execution
+	 */
+	void GatherRecipeEntriesInExecutionOrder(TArray<FActiveCharacterRecipe*, TInlineAllocator<NumInlinePendingRecipes>>& OutEntries);
+
+	/**
+	 * Build the dependency graph between the entries from the prerequisites of each CharacterRecipe
+	 * 
+	 * Tips:
+	 *	Missing prerequisites are ignored and cycles are broken, both are reported in the log once per CharacterRecipe class.
+	 *	Prerequisites not executed on this machine by their NetExecutionPolicy or baked into a committed CharacterSet are treated as satisfied.
+	 */
+	void BuildDependencyGraph(TConstArrayView<FActiveCharacterRecipe*> OrderedEntries);
+
+	/**
+	 * Calculate BuildHash and assign the key of CharacterRecipeBuildCache to the entries that cache their output
+	 */
+	void AssignBuildCacheKeys(TConstArrayView<FActiveCharacterRecipe*> OrderedEntries);
+
+	/**
+	 * Store the output of the entry whose setup process has finished in CharacterRecipeBuildCache
+	 */
+	void StoreEntryBuildOutput(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Returns whether the entry and all entries waiting for it are ClientOnly and can be deferred
+	 */
+	bool CanDeferEntry(const FActiveCharacterRecipe& Entry, int32 Depth = 0);
+
+	/**
+	 * Defer the setup process of the entry and all entries waiting for it
+	 */
+	void DeferEntry(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Start the setup process of the entries waiting for the specified entry if all their prerequisites are finished
+	 */
+	void StartDependentEntries(const FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Mark the entry as finished and update the unfinished count
+	 */
+	void MarkEntryFinished(FActiveCharacterRecipe& Entry);
+
+	/**
+	 * Switch to Complete and notify the owner component if all entries have finished
+	 */
+	void CheckAllRecipesFinished();
+
+	/**
+	 * Begin or end the trace region of the CharacterRecipe application of the owner
+	 */
+	void BeginTraceRegion();
+	void EndTraceRegion();
+
+	/**
+	 * End the trace region of the setup of the entry if it has begun
+	 */
+	void EndEntryTraceRegion(FActiveCharacterRecipe& Entry);
+
 public:
+	/**
+	 * Returns the entry of the specified handle
+	 */
+	FActiveCharacterRecipe* FindEntry(const FActiveCharacterRecipeHandle& InHandle);
+
+	/**
+	 * Returns the entry at the specified location
+	 */
+	FActiveCharacterRecipe& GetEntryAt(const FActiveCharacterRecipeLocation& Location) { return Location.bExpanded ? ExpandedEntries[Location.Index] : Entries[Location.Index]; }
+
 	/**
 	 * Returns current CharacterRecipes application state
 	 */
-	ECharacterRecipesApplicationState GetCurrentApplicationState() const;
+	ECharacterRecipesApplicationState GetCurrentApplicationState() const { return ApplicationState; }
+
+	/**
+	 * Returns hash of the committed CharacterRecipe list and the parameters of each CharacterRecipe
+	 */
+	uint32 GetBuildHash() const { return BuildHash; }
 
 };
 
 template<>
 struct TStructOpsTypeTraits<FActiveCharacterRecipeContainer> : public TStructOpsTypeTraitsBase2<FActiveCharacterRecipeContainer>
 {
-	enum { WithNetDeltaSerializer = true };
+	enum 
+	{ 
+		WithNetDeltaSerializer = true,
+		WithAddStructReferencedObjects = true,
+	};
 };
@@ -12,3 +12,19 @@ void FActiveCharacterRecipeHandle::GenerateNewHandle()
 	static int32 GHandle{ 1 };
 	Handle = GHandle++;
 }
+
+bool FActiveCharacterRecipeHandle::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Handles are small positive values, so they are sent packed. (INDEX_NONE is sent as 0)
+
+	auto PackedHandle{ static_cast<uint32>(Handle + 1) };
+	Ar.SerializeIntPacked(PackedHandle);
+
+	if (Ar.IsLoading())
+	{
+		Handle = static_cast<int32>(PackedHandle) - 1;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
@@ -4,6 +4,8 @@
 
 #include "ActiveCharacterRecipeHandle.generated.h"
 
+namespace UE::Net { struct FActiveCharacterRecipeHandleNetSerializer; }
+
 
 /**
  * Handle that points to a specific appling character recipe.
@@ -15,6 +17,9 @@ USTRUCT(BlueprintType)
 struct FActiveCharacterRecipeHandle
 {
 	GENERATED_BODY()
+
+	friend struct UE::Net::FActiveCharacterRecipeHandleNetSerializer;
+
 public:
 	FActiveCharacterRecipeHandle() : Handle(INDEX_NONE) {}
 
@@ -34,6 +39,8 @@ public:
 	bool operator==(const FActiveCharacterRecipeHandle& Other) const { return Handle == Other.Handle; }
 	bool operator!=(const FActiveCharacterRecipeHandle& Other) const { return Handle != Other.Handle; }
 
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
 public:
 	/** 
 	 * True if GenerateNewHandle was called on this handle 
@@ -51,3 +58,9 @@ public:
 	FString ToString() const { return IsValid() ? FString::FromInt(Handle) : TEXT("Invalid"); }
 
 };
+
+template<>
+struct TStructOpsTypeTraits<FActiveCharacterRecipeHandle> : public TStructOpsTypeTraitsBase2<FActiveCharacterRecipeHandle>
+{
+	enum { WithNetSerializer = true };
+};
@@ -4,18 +4,180 @@
 
 #include "CharacterInitStateComponent.h"
 #include "GCExtLogs.h"
+#include "GCExtStats.h"
 
 #include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/Async.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe)
 
 
+static bool GCharacterRecipeParallelPrepare{ true };
+static FAutoConsoleVariableRef CVarCharacterRecipeParallelPrepare(
+	TEXT("gcext.Recipe.ParallelPrepare"),
+	GCharacterRecipeParallelPrepare,
+	TEXT("Whether to run the prepare phase of CharacterRecipes on worker threads. If false, it runs on the game thread."),
+	ECVF_Default);
+
+
 UCharacterRecipe::UCharacterRecipe(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 }
 
 
+bool UCharacterRecipe::ShouldExecuteOn(bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer) const
+{
+	return (NetExecutionPolicy == ECharacterRecipeNetExecutionPolicy::Both)
+		|| (bHasAuthority && NetExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ServerOnly)
+		|| (bLocallyControlled && NetExecutionPolicy == ECharacterRecipeNetExecutionPolicy::LocalOnly)
+		|| (!bIsDedicatedServer && NetExecutionPolicy == ECharacterRecipeNetExecutionPolicy::ClientOnly);
+}
+
+
+#if WITH_EDITOR
+EDataValidationResult UCharacterRecipe::IsDataValid(TArray<FText>& ValidationErrors)
+{
+	auto Result{ CombineDataValidationResults(Super::IsDataValid(ValidationErrors), EDataValidationResult::Valid) };
+
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return Result;
+	}
+
+	// Collect all CharacterRecipes reachable through the prerequisite classes
+
+	TArray<const UCharacterRecipe*> Recipes{ this };
+
+	for (auto RecipeIndex{ 0 }; RecipeIndex < Recipes.Num(); ++RecipeIndex)
+	{
+		for (const auto& PrerequisiteSoftClass : Recipes[RecipeIndex]->GetPrerequisiteRecipeClasses())
+		{
+			const auto* PrerequisiteClass{ PrerequisiteSoftClass.LoadSynchronous() };
+
+			if (!PrerequisiteClass)
+			{
+				if (RecipeIndex == 0)
+				{
+					Result = CombineDataValidationResults(Result, EDataValidationResult::Invalid);
+
+					ValidationErrors.Add(FText::FromString(FString::Printf(TEXT("Prerequisite CharacterRecipe class (%s) is not found."), *PrerequisiteSoftClass.ToString())));
+				}
+
+				continue;
+			}
+
+			if (PrerequisiteClass == GetClass())
+			{
+				continue;
+			}
+
+			Recipes.AddUnique(GetDefault<UCharacterRecipe>(PrerequisiteClass));
+		}
+	}
+
+	TArray<const UCharacterRecipe*> Cycle;
+
+	if (FindPrerequisiteCycle(Recipes, Cycle) && Cycle.Contains(this))
+	{
+		Result = CombineDataValidationResults(Result, EDataValidationResult::Invalid);
+
+		const auto CycleString{ FString::JoinBy(Cycle, TEXT(" -> "), [](const UCharacterRecipe* Recipe) { return GetNameSafe(Recipe->GetClass()); }) };
+
+		ValidationErrors.Add(FText::FromString(FString::Printf(TEXT("Circular dependency between prerequisite CharacterRecipe classes (%s)."), *CycleString)));
+	}
+
+	return Result;
+}
+
+bool UCharacterRecipe::FindPrerequisiteCycle(TConstArrayView<const UCharacterRecipe*> Recipes, TArray<const UCharacterRecipe*>& OutCycle)
+{
+	OutCycle.Reset();
+
+	const auto NumRecipes{ Recipes.Num() };
+
+	// Resolve the prerequisites of each CharacterRecipe to the other CharacterRecipes that satisfy them
+
+	TArray<TArray<int32>> PrerequisiteIndices;
+	PrerequisiteIndices.SetNum(NumRecipes);
+
+	for (auto Index{ 0 }; Index < NumRecipes; ++Index)
+	{
+		for (auto OtherIndex{ 0 }; OtherIndex < NumRecipes; ++OtherIndex)
+		{
+			if (OtherIndex == Index)
+			{
+				continue;
+			}
+
+			const auto* Other{ Recipes[OtherIndex] };
+
+			const auto bSatisfiesClass
+			{
+				Recipes[Index]->GetPrerequisiteRecipeClasses().ContainsByPredicate(
+					[Other](const TSoftClassPtr<UCharacterRecipe>& SoftClass) { return SoftClass.Get() && Other->GetClass()->IsChildOf(SoftClass.Get()); })
+			};
+
+			if (bSatisfiesClass || Other->GetRecipeTags().HasAny(Recipes[Index]->GetPrerequisiteRecipeTags()))
+			{
+				PrerequisiteIndices[Index].Emplace(OtherIndex);
+			}
+		}
+	}
+
+	// Depth first search keeping the path of the CharacterRecipes being visited
+
+	enum class EVisitState : uint8 { None, Visiting, Visited };
+
+	TArray<EVisitState> VisitStates;
+	VisitStates.Init(EVisitState::None, NumRecipes);
+
+	TArray<int32> Path;
+
+	TFunction<bool(int32)> Visit;
+	Visit = [&](int32 Index) -> bool
+	{
+		VisitStates[Index] = EVisitState::Visiting;
+		Path.Emplace(Index);
+
+		for (const auto& PrerequisiteIndex : PrerequisiteIndices[Index])
+		{
+			if (VisitStates[PrerequisiteIndex] == EVisitState::Visiting)
+			{
+				for (auto PathIndex{ Path.Find(PrerequisiteIndex) }; PathIndex < Path.Num(); ++PathIndex)
+				{
+					OutCycle.Emplace(Recipes[Path[PathIndex]]);
+				}
+
+				OutCycle.Emplace(Recipes[PrerequisiteIndex]);
+				return true;
+			}
+
+			if ((VisitStates[PrerequisiteIndex] == EVisitState::None) && Visit(PrerequisiteIndex))
+			{
+				return true;
+			}
+		}
+
+		Path.Pop(false);
+		VisitStates[Index] = EVisitState::Visited;
+		return false;
+	};
+
+	for (auto Index{ 0 }; Index < NumRecipes; ++Index)
+	{
+		if ((VisitStates[Index] == EVisitState::None) && Visit(Index))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
+
 void UCharacterRecipe::HandleStartSetup(const FCharacterRecipePawnInfo& Info)
 {
 	check(Info.Handle.IsValid());
@@ -23,22 +185,118 @@ void UCharacterRecipe::HandleStartSetup(const FCharacterRecipePawnInfo& Info)
 	check(Info.InitStateComponent.IsValid());
 	check(!HasAllFlags(RF_ClassDefaultObject));
 
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_StartSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
 	PawnInfo = Info;
 
+	if (!HasPrepareSetupPhase())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Start Setup (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
+
+		StartSetup(PawnInfo);
+		return;
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Start Prepare (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
+
+	if (!GCharacterRecipeParallelPrepare)
+	{
+		PrepareSetup_AnyThread(Info);
+		HandlePrepareSetupFinished(Info);
+		return;
+	}
+
+	/**
+	 * The worker thread cannot resolve a weak pointer safely, so it uses the raw pointer.
+	 * This is safe because HandleDestroy(), HandleResetForPool() and BeginDestroy() wait for the task.
+	 * The game thread continuation may run after the instance is released, so it only uses the weak pointer.
+	 */
+	auto* const Recipe{ this };
+	TWeakObjectPtr<UCharacterRecipe> WeakThis{ this };
+
+	PrepareSetupTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[Recipe, WeakThis, Info]()
+		{
+			Recipe->PrepareSetup_AnyThread(Info);
+
+			AsyncTask(ENamedThreads::GameThread,
+				[WeakThis, Info]()
+				{
+					if (auto* This{ WeakThis.Get() })
+					{
+						This->HandlePrepareSetupFinished(Info);
+					}
+				});
+		});
+}
+
+void UCharacterRecipe::HandlePrepareSetupFinished(const FCharacterRecipePawnInfo& Info)
+{
+	// Ignore if destroyed or reused for another pawn while preparing
+
+	if (PawnInfo.Handle != Info.Handle)
+	{
+		return;
+	}
+
+	PrepareSetupTask = UE::Tasks::FTask();
+
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_StartSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
 	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Start Setup (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
 
 	StartSetup(PawnInfo);
 }
 
+void UCharacterRecipe::WaitForPrepareSetup()
+{
+	if (PrepareSetupTask.IsValid())
+	{
+		PrepareSetupTask.Wait();
+		PrepareSetupTask = UE::Tasks::FTask();
+	}
+}
+
 void UCharacterRecipe::HandleDestroy()
 {
 	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Destroy (%s)"), *PawnInfo.Handle.ToString(), *GetNameSafe(this));
 
+	WaitForPrepareSetup();
+
 	OnDestroy();
+
+	// Prevent StartSetup() from being executed by the prepare result that is still queued on the game thread
+
+	PawnInfo.Handle = FActiveCharacterRecipeHandle();
+}
+
+void UCharacterRecipe::HandleResetForPool()
+{
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Reset For Pool (%s)"), *PawnInfo.Handle.ToString(), *GetNameSafe(this));
+
+	WaitForPrepareSetup();
+
+	ResetForPool();
+
+	PawnInfo = FCharacterRecipePawnInfo();
+}
+
+void UCharacterRecipe::BeginDestroy()
+{
+	// Released without HandleDestroy(), e.g. when the world is torn down while preparing
+
+	WaitForPrepareSetup();
+
+	Super::BeginDestroy();
 }
 
 void UCharacterRecipe::FinishSetup()
 {
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_FinishSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
 	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Instanced] Finish Setup (%s)"), *PawnInfo.Handle.ToString(), *GetNameSafe(this));
 
 	if (PawnInfo.InitStateComponent.IsValid())
@@ -48,6 +306,24 @@ void UCharacterRecipe::FinishSetup()
 }
 
 
+void UCharacterRecipe::HandleApplyBuildOutput(const FCharacterRecipePawnInfo& Info, const UCharacterRecipeBuildOutput* Output) const
+{
+	check(Info.Handle.IsValid());
+	check(Info.Pawn.IsValid());
+	check(Info.InitStateComponent.IsValid());
+	check(Output);
+
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_StartSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][Cached] Apply Build Output (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
+
+	ApplyBuildOutput(Info, Output);
+
+	Info.InitStateComponent->HandleRecipeSetupFinished(Info.Handle);
+}
+
+
 APawn* UCharacterRecipe::GetTypedPawn(TSubclassOf<APawn> InClass) const
 {
 	return PawnInfo.Pawn.Get();
@@ -61,9 +337,28 @@ void UCharacterRecipe::HandleStartSetupNonInstanced(const FCharacterRecipePawnIn
 	check(Info.InitStateComponent.IsValid());
 	check(HasAllFlags(RF_ClassDefaultObject));
 
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_StartSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
 	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][NonInstanced] Start Setup (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
 
 	StartSetupNonInstanced(Info);
 
-	Info.InitStateComponent->HandleRecipeSetupFinished(Info.Handle);
+	if (!IsSetupNonInstancedAsync())
+	{
+		FinishSetupNonInstanced(Info);
+	}
+}
+
+void UCharacterRecipe::FinishSetupNonInstanced(const FCharacterRecipePawnInfo& Info) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GCExt_FinishSetup);
+	GCEXT_SCOPE_RECIPE(GetClass());
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("| [%s][NonInstanced] Finish Setup (%s)"), *Info.Handle.ToString(), *GetNameSafe(this));
+
+	if (Info.InitStateComponent.IsValid())
+	{
+		Info.InitStateComponent->HandleRecipeSetupFinished(Info.Handle);
+	}
 }
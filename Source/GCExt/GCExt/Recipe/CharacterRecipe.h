@@ -5,10 +5,16 @@
 #include "Recipe/CharacterRecipePolicyTypes.h"
 #include "Recipe/ActiveCharacterRecipeHandle.h"
 
+#include "GameplayTagContainer.h"
+
+#include "Tasks/Task.h"
+
 #include "CharacterRecipe.generated.h"
 
 class APawn;
 class UCharacterInitStateComponent;
+class UCharacterRecipeBuildOutput;
+class UCharacterBakedBuild;
 
 
 /**
@@ -63,6 +69,16 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Policies")
 	ECharacterRecipeNetExecutionPolicy NetExecutionPolicy{ ECharacterRecipeNetExecutionPolicy::Both };
 
+	//
+	// Whether instances of this CharacterRecipe are recycled through the world instance pool
+	// 
+	// Tips:
+	//	Only used if InstancingPolicy is "Instanced".
+	//	ResetForPool must restore all state of the instance so that it can be reused by another pawn.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Policies", meta = (EditCondition = "InstancingPolicy == ECharacterRecipeInstancingPolicy::Instanced"))
+	bool bAllowInstancePooling{ false };
+
 public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Policies")
 	ECharacterRecipeInstancingPolicy GetInstancingPolicy() const { return InstancingPolicy; }
@@ -70,6 +86,151 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Policies")
 	ECharacterRecipeNetExecutionPolicy GetNetExecutionPolicy() const { return NetExecutionPolicy; }
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Policies")
+	bool IsInstancePoolingAllowed() const { return bAllowInstancePooling; }
+
+	/**
+	 * Returns whether this CharacterRecipe is executed on the machine with the specified role by NetExecutionPolicy
+	 */
+	bool ShouldExecuteOn(bool bHasAuthority, bool bLocallyControlled, bool bIsDedicatedServer) const;
+
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Dependencies
+protected:
+	//
+	// Tags to identify this CharacterRecipe from the prerequisites of other CharacterRecipes
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies")
+	FGameplayTagContainer RecipeTags;
+
+	//
+	// CharacterRecipe classes that must finish before this CharacterRecipe starts
+	// 
+	// Tips:
+	//	Derived classes of the specified class also match.
+	//	Soft references so that ClientOnly prerequisites are not cooked for dedicated servers through this reference.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies")
+	TArray<TSoftClassPtr<UCharacterRecipe>> PrerequisiteRecipeClasses;
+
+	//
+	// Tags of CharacterRecipes that must finish before this CharacterRecipe starts
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Dependencies")
+	FGameplayTagContainer PrerequisiteRecipeTags;
+
+public:
+	const FGameplayTagContainer& GetRecipeTags() const { return RecipeTags; }
+	const TArray<TSoftClassPtr<UCharacterRecipe>>& GetPrerequisiteRecipeClasses() const { return PrerequisiteRecipeClasses; }
+	const FGameplayTagContainer& GetPrerequisiteRecipeTags() const { return PrerequisiteRecipeTags; }
+
+	/**
+	 * Returns whether this CharacterRecipe has any prerequisites
+	 */
+	bool HasPrerequisites() const { return !PrerequisiteRecipeClasses.IsEmpty() || !PrerequisiteRecipeTags.IsEmpty(); }
+
+	/**
+	 * Returns whether this CharacterRecipe can start while the mesh changes of the preceding CharacterRecipes are still staged
+	 * 
+	 * Tips:
+	 *	The staged mesh changes are committed before any other CharacterRecipe starts, so that it sees the results of the preceding ones.
+	 *	Override to return true only if this CharacterRecipe does not read the meshes before staging its own changes.
+	 */
+	virtual bool CanStartWithStagedMeshChanges() const { return false; }
+
+#if WITH_EDITOR
+public:
+	virtual EDataValidationResult IsDataValid(TArray<FText>& ValidationErrors) override;
+
+	/**
+	 * Find a circular dependency between the prerequisites of the CharacterRecipes
+	 *
+	 * Tips:
+	 *	Prerequisites are resolved among the specified CharacterRecipes in the same way as on the pawn.
+	 *	OutCycle receives the CharacterRecipes of the first cycle found in the order of dependency.
+	 */
+	static bool FindPrerequisiteCycle(TConstArrayView<const UCharacterRecipe*> Recipes, TArray<const UCharacterRecipe*>& OutCycle);
+#endif
+
+
+	//////////////////////////////////////////////////////////////////////////////////
+	// Build Output Cache
+protected:
+	//
+	// Whether the resolved output of this CharacterRecipe is cached and applied directly to pawns with the same build
+	//
+	// Tips:
+	//	Only effective if the CharacterRecipe supports the build output cache, such as CharacterRecipe_SetMesh.
+	//	Pawns have the same build if the committed CharacterRecipe list and the parameter hash of each CharacterRecipe match.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Policies", meta = (EditCondition = "bSupportsBuildOutputCache", EditConditionHides))
+	bool bCacheBuildOutput{ false };
+
+	//
+	// Whether this CharacterRecipe class implements CreateBuildOutput() and ApplyBuildOutput()
+	//
+	// Tips:
+	//	Set in the constructor of native classes only, since both functions are native-only.
+	//	Blueprint classes inherit the value of their native parent.
+	//
+	UPROPERTY(Transient)
+	bool bSupportsBuildOutputCache{ false };
+
+public:
+	/**
+	 * Returns whether the resolved output of this CharacterRecipe is cached
+	 */
+	bool IsBuildOutputCacheEnabled() const { return bSupportsBuildOutputCache && bCacheBuildOutput; }
+
+	/**
+	 * Returns hash of the parameters that change the output of this CharacterRecipe for the pawn
+	 *
+	 * Tips:
+	 *	Override if the output depends on the pawn, so that pawns with different outputs do not share the cache
+	 */
+	virtual uint32 GetBuildParameterHash(const FCharacterRecipePawnInfo& Info) const { return 0; }
+
+	/**
+	 * Create the output resolved by the finished setup process to store in the build cache
+	 *
+	 * Tips:
+	 *	Executed on the object that executed the setup process. (Instance or CDO)
+	 */
+	virtual UCharacterRecipeBuildOutput* CreateBuildOutput(UObject* Outer, const FCharacterRecipePawnInfo& Info) const { return nullptr; }
+
+	/**
+	 * Apply the cached output instead of executing the setup process
+	 */
+	void HandleApplyBuildOutput(const FCharacterRecipePawnInfo& Info, const UCharacterRecipeBuildOutput* Output) const;
+
+protected:
+	/**
+	 * Apply the cached output to the pawn
+	 *
+	 * Tips:
+	 *	Executed on the CDO and must finish synchronously.
+	 *	For Instanced CharacterRecipes, the instance is released without StartSetup() or OnDestroy() being called,
+	 *	so the applied output must not need to be undone when the pawn is destroyed.
+	 */
+	virtual void ApplyBuildOutput(const FCharacterRecipePawnInfo& Info, const UCharacterRecipeBuildOutput* Output) const {}
+
+#if WITH_EDITOR
+public:
+	/**
+	 * Returns whether the output of this CharacterRecipe is deterministic and can be baked into CharacterBakedBuild
+	 * 
+	 * Tips:
+	 *	Baked CharacterRecipes are not added to the pawn, so they must not depend on the pawn or hold any state
+	 */
+	virtual bool CanBakeBuild() const { return false; }
+
+	/**
+	 * Write the output of this CharacterRecipe into the baked build
+	 */
+	virtual void BakeBuild(UCharacterBakedBuild* BakedBuild) const {}
+#endif
+
 
 	//////////////////////////////////////////////////////////////////////////////////
 	// Instanced
@@ -80,6 +241,11 @@ protected:
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Info")
 	FCharacterRecipePawnInfo PawnInfo;
 
+	//
+	// Task running PrepareSetup_AnyThread()
+	//
+	UE::Tasks::FTask PrepareSetupTask;
+
 public:
 	/**
 	 * Executed when all CharacterRecipes are added and setup begins.
@@ -91,6 +257,58 @@ public:
 	 */
 	void HandleDestroy();
 
+	/**
+	 * Executed when the instance is returned to the instance pool
+	 */
+	void HandleResetForPool();
+
+	virtual void BeginDestroy() override;
+
+	/**
+	 * Executed when the significance of the pawn is reevaluated
+	 * 
+	 * Tips:
+	 *	Only executed on instances registered by CharacterRecipeSubsystem::RegisterSignificanceListener()
+	 */
+	virtual void HandleSignificanceUpdated(float Significance) {}
+
+protected:
+	/**
+	 * Returns whether this CharacterRecipe has a thread-safe prepare phase
+	 * 
+	 * Tips:
+	 *	If true, PrepareSetup_AnyThread() is executed on a worker thread before StartSetup()
+	 * 
+	 * Note:
+	 *	The prepare phase is native-only and used only when InstancingPolicy is "Instanced".
+	 *	NonInstanced CharacterRecipes share the CDO between pawns, so there is no instance to store the prepared data in.
+	 */
+	virtual bool HasPrepareSetupPhase() const { return false; }
+
+	/**
+	 * Thread-safe data preparation executed before StartSetup()
+	 * 
+	 * Tips:
+	 *	Use this for pure data processing such as resolving variant tables or building arrays,
+	 *	and store the results in this instance so that StartSetup() only applies them.
+	 * 
+	 * Note:
+	 *	Runs on a worker thread. Do not access the pawn, its components or any other UObject state, and do not create UObjects.
+	 *	The instance is kept alive until it finishes, since HandleDestroy(), HandleResetForPool() and BeginDestroy() wait for it.
+	 */
+	virtual void PrepareSetup_AnyThread(const FCharacterRecipePawnInfo& Info) {}
+
+private:
+	/**
+	 * Executed on the game thread when PrepareSetup_AnyThread() is finished
+	 */
+	void HandlePrepareSetupFinished(const FCharacterRecipePawnInfo& Info);
+
+	/**
+	 * Wait for the running PrepareSetup_AnyThread() to finish
+	 */
+	void WaitForPrepareSetup();
+
 protected:
 	/**
 	 * Executed when all CharacterRecipes are added and setup begins.
@@ -119,6 +337,19 @@ protected:
 	void OnDestroy();
 	virtual void OnDestroy_Implementation() {}
 
+	/**
+	 * Executed when the instance is returned to the instance pool
+	 *
+	 * Tips:
+	 *	This function is executed only when bAllowInstancePooling is true
+	 *
+	 * Note:
+	 *	Reset all state held by this instance so that it behaves the same as a newly created instance.
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "Setup")
+	void ResetForPool();
+	virtual void ResetForPool_Implementation() {}
+
 	/**
 	 * Notify the InitState component that the setup process is finished
 	 */
@@ -155,4 +386,17 @@ protected:
 	void StartSetupNonInstanced(FCharacterRecipePawnInfo Info) const;
 	virtual void StartSetupNonInstanced_Implementation(FCharacterRecipePawnInfo Info) const {}
 
+	/**
+	 * Returns whether the setup process of NonInstanced finishes asynchronously
+	 * 
+	 * Tips:
+	 *	If true, FinishSetupNonInstanced() must be called when the processing is complete
+	 */
+	virtual bool IsSetupNonInstancedAsync() const { return false; }
+
+	/**
+	 * Notify the InitState component that the setup process of NonInstanced is finished
+	 */
+	void FinishSetupNonInstanced(const FCharacterRecipePawnInfo& Info) const;
+
 };
@@ -0,0 +1,49 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeBuildCache.h"
+
+#include "HAL/IConsoleManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipeBuildCache)
+
+
+static int32 GCharacterRecipeBuildCacheMaxEntries{ 256 };
+static FAutoConsoleVariableRef CVarCharacterRecipeBuildCacheMaxEntries(
+	TEXT("gcext.Recipe.BuildCacheMaxEntries"),
+	GCharacterRecipeBuildCacheMaxEntries,
+	TEXT("Maximum number of CharacterRecipe build outputs kept in the cache per world. 0 disables the cache."),
+	ECVF_Default);
+
+
+bool UCharacterRecipeBuildCache::IsBuildCacheEnabled()
+{
+	return GCharacterRecipeBuildCacheMaxEntries > 0;
+}
+
+const UCharacterRecipeBuildOutput* UCharacterRecipeBuildCache::FindBuildOutput(const FCharacterRecipeBuildCacheKey& Key)
+{
+	const auto* FoundOutput{ Key.IsValid() ? BuildOutputs.Find(Key.Hash) : nullptr };
+	const UCharacterRecipeBuildOutput* Output{ (FoundOutput && *FoundOutput && ((*FoundOutput)->BuildCacheKey == Key)) ? FoundOutput->Get() : nullptr };
+
+	RecordLookup(Output != nullptr);
+
+	return Output;
+}
+
+void UCharacterRecipeBuildCache::StoreBuildOutput(const FCharacterRecipeBuildCacheKey& Key, UCharacterRecipeBuildOutput* Output)
+{
+	if (Output && Key.IsValid())
+	{
+		// An output of another build with the same hash is replaced
+
+		Output->BuildCacheKey = Key;
+
+		BuildOutputKeys.Add(BuildOutputs, Key.Hash, Output, GCharacterRecipeBuildCacheMaxEntries);
+	}
+}
+
+void UCharacterRecipeBuildCache::ClearCache()
+{
+	BuildOutputs.Empty();
+	BuildOutputKeys.Reset();
+}
@@ -0,0 +1,176 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipeCacheSubsystem.h"
+
+#include "UObject/ObjectKey.h"
+
+#include "CharacterRecipeBuildCache.generated.h"
+
+
+/**
+ * List of the committed CharacterRecipes and the parameters of each CharacterRecipe that determines the build of a pawn
+ *
+ * Tips:
+ *	Shared by all entries of the container that calculated it and by the outputs stored for them.
+ */
+struct FCharacterRecipeBuildSignature
+{
+public:
+	FCharacterRecipeBuildSignature() {}
+
+public:
+	//
+	// CharacterRecipe classes in the order of execution
+	//
+	TArray<FObjectKey> RecipeClasses;
+
+	//
+	// Parameter hash of each CharacterRecipe in the order of execution
+	//
+	TArray<uint32> ParameterHashes;
+
+	//
+	// Hash of RecipeClasses and ParameterHashes
+	//
+	uint32 Hash{ 0 };
+
+public:
+	bool operator==(const FCharacterRecipeBuildSignature& Other) const
+	{
+		return (Hash == Other.Hash) && (RecipeClasses == Other.RecipeClasses) && (ParameterHashes == Other.ParameterHashes);
+	}
+
+};
+
+
+/**
+ * Key of the output of a CharacterRecipe in CharacterRecipeBuildCache
+ *
+ * Tips:
+ *	The hash is only used to find the output, the full signature is compared on a hit
+ *	so that a hash collision does not apply the output of another build.
+ */
+struct FCharacterRecipeBuildCacheKey
+{
+public:
+	FCharacterRecipeBuildCacheKey() {}
+
+	FCharacterRecipeBuildCacheKey(const TSharedRef<const FCharacterRecipeBuildSignature>& InSignature, int32 InIndex)
+		: Signature(InSignature)
+		, Index(InIndex)
+		, Hash(HashCombine(InSignature->Hash, static_cast<uint32>(InIndex)))
+	{}
+
+public:
+	//
+	// Signature of the build the CharacterRecipe belongs to
+	//
+	TSharedPtr<const FCharacterRecipeBuildSignature> Signature;
+
+	//
+	// Index of the CharacterRecipe in the signature
+	//
+	int32 Index{ INDEX_NONE };
+
+	//
+	// Hash of the signature and the index used as the key of the map
+	//
+	uint32 Hash{ 0 };
+
+public:
+	/**
+	 * Returns whether the key is assigned
+	 */
+	bool IsValid() const { return Signature.IsValid(); }
+
+	/**
+	 * Clear the key
+	 */
+	void Reset() { *this = FCharacterRecipeBuildCacheKey(); }
+
+	bool operator==(const FCharacterRecipeBuildCacheKey& Other) const
+	{
+		if ((Hash != Other.Hash) || (Index != Other.Index) || !Signature.IsValid() || !Other.Signature.IsValid())
+		{
+			return false;
+		}
+
+		return (Signature == Other.Signature) || (*Signature == *Other.Signature);
+	}
+
+};
+
+
+/**
+ * Base class of the resolved output of a CharacterRecipe that can be reused by other pawns with the same build
+ *
+ * Tips:
+ *	Create a derived class for each CharacterRecipe that supports the build output cache,
+ *	holding hard references to the resolved assets and values so that they can be applied directly.
+ */
+UCLASS(Abstract, Transient)
+class GCEXT_API UCharacterRecipeBuildOutput : public UObject
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeBuildOutput() {}
+
+public:
+	//
+	// Key of the build this output was created for
+	//
+	FCharacterRecipeBuildCacheKey BuildCacheKey;
+
+};
+
+
+/**
+ * World subsystem that holds the resolved outputs of CharacterRecipes keyed by the build signature
+ *
+ * Tips:
+ *	The key is made from the list of committed CharacterRecipes and the parameters of each CharacterRecipe,
+ *	so a pawn with the same build gets the outputs applied directly instead of running the setup process.
+ *	Outputs found by hash are only applied if their full signature matches.
+ *	The maximum number of outputs kept can be changed with "gcext.Recipe.BuildCacheMaxEntries".
+ */
+UCLASS()
+class GCEXT_API UCharacterRecipeBuildCache : public UCharacterRecipeCacheSubsystem
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeBuildCache() {}
+
+	virtual void ClearCache() override;
+	virtual int32 GetNumCachedEntries() const override { return BuildOutputs.Num(); }
+
+protected:
+	//
+	// Mapping list of the hash of the cache key and the build output
+	//
+	UPROPERTY(Transient)
+	TMap<uint32, TObjectPtr<UCharacterRecipeBuildOutput>> BuildOutputs;
+
+	//
+	// Cache keys in the order of addition, used to remove the oldest output
+	//
+	FCharacterRecipeCacheKeyOrder BuildOutputKeys;
+
+public:
+	/**
+	 * Returns whether the build output cache is enabled
+	 */
+	static bool IsBuildCacheEnabled();
+
+	/**
+	 * Returns the output of the specified key, or nullptr if not cached or cached for another build with the same hash
+	 */
+	const UCharacterRecipeBuildOutput* FindBuildOutput(const FCharacterRecipeBuildCacheKey& Key);
+
+	/**
+	 * Add the output of the specified key to the cache
+	 */
+	void StoreBuildOutput(const FCharacterRecipeBuildCacheKey& Key, UCharacterRecipeBuildOutput* Output);
+
+};
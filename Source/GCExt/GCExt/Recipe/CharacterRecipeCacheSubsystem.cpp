@@ -0,0 +1,31 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeCacheSubsystem.h"
+
+#include "GCExtLogs.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipeCacheSubsystem)
+
+
+void UCharacterRecipeCacheSubsystem::Deinitialize()
+{
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("%s released (Hits: %d, Misses: %d, HitRate: %.2f, Cached: %d)")
+		, *GetNameSafe(GetClass()), NumHits, NumMisses, GetCacheHitRate(), GetNumCachedEntries());
+
+	ClearCache();
+
+	Super::Deinitialize();
+}
+
+bool UCharacterRecipeCacheSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+
+float UCharacterRecipeCacheSubsystem::GetCacheHitRate() const
+{
+	const auto NumLookups{ NumHits + NumMisses };
+
+	return (NumLookups > 0) ? static_cast<float>(NumHits) / static_cast<float>(NumLookups) : 0.0f;
+}
@@ -0,0 +1,141 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CharacterRecipeCacheSubsystem.generated.h"
+
+
+/**
+ * Order of the keys added to a cache, used to remove the oldest entries when the cache is full
+ */
+struct FCharacterRecipeCacheKeyOrder
+{
+public:
+	FCharacterRecipeCacheKeyOrder() {}
+
+protected:
+	//
+	// Cache keys in the order of addition
+	//
+	TArray<uint32> Keys;
+
+public:
+	/**
+	 * Add the value of the key to the map and remove the oldest entries exceeding MaxEntries
+	 *
+	 * Tips:
+	 *	Nothing is added if MaxEntries is 0 or less.
+	 */
+	template<typename MapType, typename ValueType>
+	void Add(MapType& Map, uint32 Key, ValueType&& Value, int32 MaxEntries)
+	{
+		if (MaxEntries <= 0)
+		{
+			return;
+		}
+
+		if (!Map.Contains(Key))
+		{
+			Keys.Emplace(Key);
+		}
+
+		Map.Add(Key, Forward<ValueType>(Value));
+
+		const auto NumToRemove{ Keys.Num() - MaxEntries };
+
+		if (NumToRemove > 0)
+		{
+			for (auto Index{ 0 }; Index < NumToRemove; ++Index)
+			{
+				Map.Remove(Keys[Index]);
+			}
+
+			Keys.RemoveAt(0, NumToRemove, false);
+		}
+	}
+
+	/**
+	 * Remove all keys
+	 */
+	void Reset()
+	{
+		Keys.Empty();
+	}
+
+};
+
+
+/**
+ * Base class of the world subsystems that cache CharacterRecipe objects for reuse by other pawns
+ *
+ * Tips:
+ *	Counts the lookups found and not found in the cache, and logs them when the world is released.
+ *	Derived classes record each lookup with RecordLookup() and implement ClearCache() and GetNumCachedEntries().
+ *	The size of each cache is limited by its own "gcext.Recipe.*" console variable.
+ */
+UCLASS(Abstract)
+class GCEXT_API UCharacterRecipeCacheSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeCacheSubsystem() {}
+
+	virtual void Deinitialize() override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+protected:
+	//
+	// Number of times an entry was found in the cache
+	//
+	int32 NumHits{ 0 };
+
+	//
+	// Number of times an entry was not found in the cache
+	//
+	int32 NumMisses{ 0 };
+
+protected:
+	/**
+	 * Count a lookup of the cache
+	 */
+	void RecordLookup(bool bHit)
+	{
+		bHit ? ++NumHits : ++NumMisses;
+	}
+
+public:
+	/**
+	 * Remove all entries from the cache
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Recipes")
+	virtual void ClearCache() {}
+
+	/**
+	 * Returns number of entries currently cached
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	virtual int32 GetNumCachedEntries() const { return 0; }
+
+	/**
+	 * Returns number of times an entry was found in the cache
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumCacheHits() const { return NumHits; }
+
+	/**
+	 * Returns number of times an entry was not found in the cache
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumCacheMisses() const { return NumMisses; }
+
+	/**
+	 * Returns ratio of the lookups found in the cache
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	float GetCacheHitRate() const;
+
+};
@@ -0,0 +1,75 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeInstancePool.h"
+
+#include "Recipe/CharacterRecipe.h"
+
+#include "HAL/IConsoleManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipeInstancePool)
+
+
+static int32 GCharacterRecipeInstancePoolMaxPerClass{ 64 };
+static FAutoConsoleVariableRef CVarCharacterRecipeInstancePoolMaxPerClass(
+	TEXT("gcext.Recipe.InstancePoolMaxPerClass"),
+	GCharacterRecipeInstancePoolMaxPerClass,
+	TEXT("Maximum number of CharacterRecipe instances kept in the pool per class. 0 disables pooling."),
+	ECVF_Default);
+
+
+void UCharacterRecipeInstancePool::ClearCache()
+{
+	PooledInstances.Empty();
+}
+
+
+UCharacterRecipe* UCharacterRecipeInstancePool::AcquireInstance(TSubclassOf<UCharacterRecipe> InClass)
+{
+	check(InClass);
+
+	if (auto* Entry{ PooledInstances.Find(InClass.Get()) })
+	{
+		if (!Entry->Instances.IsEmpty())
+		{
+			RecordLookup(true);
+
+			return Entry->Instances.Pop(false);
+		}
+	}
+
+	RecordLookup(false);
+
+	return NewObject<UCharacterRecipe>(this, InClass);
+}
+
+void UCharacterRecipeInstancePool::ReleaseInstance(UCharacterRecipe* Instance)
+{
+	check(Instance);
+	check(Instance->GetOuter() == this);
+
+	auto& Entry{ PooledInstances.FindOrAdd(Instance->GetClass()) };
+
+	// Discard the instance if the pool is already full
+
+	if (Entry.Instances.Num() >= GCharacterRecipeInstancePoolMaxPerClass)
+	{
+		return;
+	}
+
+	Instance->HandleResetForPool();
+
+	Entry.Instances.Emplace(Instance);
+}
+
+
+int32 UCharacterRecipeInstancePool::GetNumCachedEntries() const
+{
+	auto Count{ 0 };
+
+	for (const auto& KVP : PooledInstances)
+	{
+		Count += KVP.Value.Instances.Num();
+	}
+
+	return Count;
+}
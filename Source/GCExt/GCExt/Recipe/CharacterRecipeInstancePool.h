@@ -0,0 +1,65 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipeCacheSubsystem.h"
+
+#include "CharacterRecipeInstancePool.generated.h"
+
+class UCharacterRecipe;
+
+
+/**
+ * List of pooled instances of a CharacterRecipe class
+ */
+USTRUCT()
+struct FCharacterRecipeInstancePoolEntry
+{
+	GENERATED_BODY()
+public:
+	FCharacterRecipeInstancePoolEntry() {}
+
+public:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCharacterRecipe>> Instances;
+
+};
+
+
+/**
+ * World subsystem that recycles instances of Instanced CharacterRecipes for each class
+ *
+ * Tips:
+ *	Only CharacterRecipe classes with bAllowInstancePooling enabled are pooled.
+ *	A hit is counted when an instance is reused from the pool, and a miss when a new instance has to be created.
+ *	The maximum number of instances kept per class can be changed with "gcext.Recipe.InstancePoolMaxPerClass".
+ */
+UCLASS()
+class GCEXT_API UCharacterRecipeInstancePool : public UCharacterRecipeCacheSubsystem
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeInstancePool() {}
+
+	virtual void ClearCache() override;
+	virtual int32 GetNumCachedEntries() const override;
+
+protected:
+	//
+	// Mapping list of CharacterRecipe class and its pooled instances
+	//
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FCharacterRecipeInstancePoolEntry> PooledInstances;
+
+public:
+	/**
+	 * Returns an instance of the specified class, reusing a pooled instance if possible
+	 */
+	UCharacterRecipe* AcquireInstance(TSubclassOf<UCharacterRecipe> InClass);
+
+	/**
+	 * Reset the instance and return it to the pool
+	 */
+	void ReleaseInstance(UCharacterRecipe* Instance);
+
+};
@@ -0,0 +1,197 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeNetSerializers.h"
+
+#if UE_WITH_IRIS
+
+#include "Recipe/ActiveCharacterRecipeHandle.h"
+#include "Recipe/CharacterRecipeRegistry.h"
+
+#include "Iris/Serialization/NetBitStreamUtil.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+
+
+namespace UE::Net
+{
+
+//////////////////////////////////////////////////////
+// FActiveCharacterRecipeHandleNetSerializer
+
+#pragma region FActiveCharacterRecipeHandleNetSerializer
+
+struct FActiveCharacterRecipeHandleNetSerializer
+{
+	static const uint32 Version{ 0 };
+
+	typedef FActiveCharacterRecipeHandle SourceType;
+	typedef uint32 QuantizedType;
+	typedef FNetSerializerConfig ConfigType;
+
+	inline static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+	{
+		const auto& Value{ *reinterpret_cast<const QuantizedType*>(Args.Source) };
+
+		WritePackedUint32(Context.GetBitStreamWriter(), Value);
+	}
+
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+	{
+		auto& Target{ *reinterpret_cast<QuantizedType*>(Args.Target) };
+
+		Target = ReadPackedUint32(Context.GetBitStreamReader());
+	}
+
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+	{
+		const auto& Source{ *reinterpret_cast<const SourceType*>(Args.Source) };
+		auto& Target{ *reinterpret_cast<QuantizedType*>(Args.Target) };
+
+		// Same as NetSerialize(), INDEX_NONE is quantized as 0
+
+		Target = static_cast<QuantizedType>(Source.Handle + 1);
+	}
+
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+	{
+		const auto& Source{ *reinterpret_cast<const QuantizedType*>(Args.Source) };
+		auto& Target{ *reinterpret_cast<SourceType*>(Args.Target) };
+
+		Target.Handle = static_cast<int32>(Source) - 1;
+	}
+
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+	{
+		if (Args.bStateIsQuantized)
+		{
+			return *reinterpret_cast<const QuantizedType*>(Args.Source0) == *reinterpret_cast<const QuantizedType*>(Args.Source1);
+		}
+
+		return *reinterpret_cast<const SourceType*>(Args.Source0) == *reinterpret_cast<const SourceType*>(Args.Source1);
+	}
+
+private:
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	inline static FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+
+};
+
+UE_NET_IMPLEMENT_SERIALIZER(FActiveCharacterRecipeHandleNetSerializer);
+
+static const FName PropertyNetSerializerRegistry_NAME_ActiveCharacterRecipeHandle{ TEXTVIEW("ActiveCharacterRecipeHandle") };
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_ActiveCharacterRecipeHandle, FActiveCharacterRecipeHandleNetSerializer);
+
+FActiveCharacterRecipeHandleNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_ActiveCharacterRecipeHandle);
+}
+
+void FActiveCharacterRecipeHandleNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_ActiveCharacterRecipeHandle);
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////
+// FCharacterRecipeClassIndexNetSerializer
+
+#pragma region FCharacterRecipeClassIndexNetSerializer
+
+struct FCharacterRecipeClassIndexNetSerializer
+{
+	static const uint32 Version{ 0 };
+
+	typedef FCharacterRecipeClassIndex SourceType;
+	typedef uint16 QuantizedType;
+	typedef FNetSerializerConfig ConfigType;
+
+	inline static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+	{
+		const auto& Value{ *reinterpret_cast<const QuantizedType*>(Args.Source) };
+
+		WritePackedUint32(Context.GetBitStreamWriter(), Value);
+	}
+
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+	{
+		auto& Target{ *reinterpret_cast<QuantizedType*>(Args.Target) };
+
+		Target = static_cast<QuantizedType>(ReadPackedUint32(Context.GetBitStreamReader()));
+	}
+
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+	{
+		const auto& Source{ *reinterpret_cast<const SourceType*>(Args.Source) };
+		auto& Target{ *reinterpret_cast<QuantizedType*>(Args.Target) };
+
+		// Same as NetSerialize(), INDEX_Invalid is quantized as 0
+
+		Target = static_cast<QuantizedType>(Source.Index + 1);
+	}
+
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+	{
+		const auto& Source{ *reinterpret_cast<const QuantizedType*>(Args.Source) };
+		auto& Target{ *reinterpret_cast<SourceType*>(Args.Target) };
+
+		Target.Index = static_cast<uint16>(Source - 1);
+	}
+
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+	{
+		if (Args.bStateIsQuantized)
+		{
+			return *reinterpret_cast<const QuantizedType*>(Args.Source0) == *reinterpret_cast<const QuantizedType*>(Args.Source1);
+		}
+
+		return *reinterpret_cast<const SourceType*>(Args.Source0) == *reinterpret_cast<const SourceType*>(Args.Source1);
+	}
+
+private:
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	inline static FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+
+};
+
+UE_NET_IMPLEMENT_SERIALIZER(FCharacterRecipeClassIndexNetSerializer);
+
+static const FName PropertyNetSerializerRegistry_NAME_CharacterRecipeClassIndex{ TEXTVIEW("CharacterRecipeClassIndex") };
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_CharacterRecipeClassIndex, FCharacterRecipeClassIndexNetSerializer);
+
+FCharacterRecipeClassIndexNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_CharacterRecipeClassIndex);
+}
+
+void FCharacterRecipeClassIndexNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_CharacterRecipeClassIndex);
+}
+
+#pragma endregion
+
+}
+
+#endif
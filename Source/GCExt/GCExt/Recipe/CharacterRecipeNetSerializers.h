@@ -0,0 +1,36 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#if UE_WITH_IRIS
+
+#include "Iris/Serialization/NetSerializer.h"
+
+/**
+ * Iris NetSerializers of the structs replicated by ActiveCharacterRecipeContainer
+ *
+ * Tips:
+ *	These serialize the same packed format as NetSerialize() of each struct, so the container replicates
+ *	with the Iris FastArray replication fragment without falling back to the last resort serializer.
+ *
+ * Note:
+ *	The container has no dedicated replication fragment and uses the built-in FastArray fragment,
+ *	which already calls PostReplicatedAdd/Change/Remove of the container.
+ *	Dirty tracking is the push-model flag of UCharacterInitStateComponent::ActiveCharacterRecipes,
+ *	which is marked on commit, the only time the replicated entries change, and is read by Iris as well.
+ *
+ *	A dedicated fragment would not add the per-connection filtering of ServerOnly and LocalOnly entries:
+ *	Iris quantizes one replication state per object and sends the same items to every connection,
+ *	so a fragment cannot drop items for some connections as ShouldWriteFastArrayItem() does.
+ *	With Iris those entries reach all clients and are skipped there by NetExecutionPolicy,
+ *	so ServerOnly CharacterRecipes must not rely on their class being unknown to clients.
+ *	Use the generic replication system for the pawns if the bytes of those entries matter.
+ *	Bytes sent can be measured with gcext.Recipe.Benchmark on a listen server with clients connected.
+ */
+namespace UE::Net
+{
+	UE_NET_DECLARE_SERIALIZER(FActiveCharacterRecipeHandleNetSerializer, GCEXT_API);
+	UE_NET_DECLARE_SERIALIZER(FCharacterRecipeClassIndexNetSerializer, GCEXT_API);
+}
+
+#endif
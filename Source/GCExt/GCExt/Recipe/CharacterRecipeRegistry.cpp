@@ -0,0 +1,240 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeRegistry.h"
+
+#include "Recipe/CharacterRecipe.h"
+#include "CharacterSet.h"
+#include "GCExtLogs.h"
+
+#include "Misc/NetworkVersion.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipeRegistry)
+
+
+//////////////////////////////////////////////////////
+// FCharacterRecipeClassIndex
+
+#pragma region FCharacterRecipeClassIndex
+
+bool FCharacterRecipeClassIndex::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Indices are small positive values, so they are sent packed. (INDEX_Invalid is sent as 0)
+
+	auto PackedIndex{ static_cast<uint32>(static_cast<uint16>(Index + 1)) };
+	Ar.SerializeIntPacked(PackedIndex);
+
+	if (Ar.IsLoading())
+	{
+		Index = static_cast<uint16>(PackedIndex - 1);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////
+// UCharacterRecipeRegistry
+
+#pragma region UCharacterRecipeRegistry
+
+UCharacterRecipeRegistry::UCharacterRecipeRegistry()
+{
+	CategoryName = TEXT("Game");
+}
+
+void UCharacterRecipeRegistry::PostReloadConfig(FProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+
+	if (bRegistryBuilt)
+	{
+		RebuildRegistry();
+	}
+}
+
+#if WITH_EDITOR
+void UCharacterRecipeRegistry::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UCharacterRecipeRegistry, AdditionalRecipeClasses))
+	{
+		RebuildRegistry();
+	}
+}
+#endif
+
+const UCharacterRecipeRegistry* UCharacterRecipeRegistry::Get()
+{
+	auto* Registry{ GetMutableDefault<UCharacterRecipeRegistry>() };
+
+	if (!Registry->bRegistryBuilt)
+	{
+		Registry->RebuildRegistry();
+	}
+
+	return Registry;
+}
+
+
+bool UCharacterRecipeRegistry::RebuildRegistry()
+{
+	bRegistryBuilt = true;
+
+	TSet<FSoftClassPath> FoundClasses;
+
+	// Classes known to the AssetRegistry, which is the cooked AssetRegistry in packaged builds
+
+	if (auto* AssetRegistryModule{ FModuleManager::LoadModulePtr<FAssetRegistryModule>(AssetRegistryConstants::ModuleName) })
+	{
+		TSet<FTopLevelAssetPath> DerivedClassNames;
+		AssetRegistryModule->Get().GetDerivedClassNames({ UCharacterRecipe::StaticClass()->GetClassPathName() }, {}, DerivedClassNames);
+
+		FoundClasses.Reserve(DerivedClassNames.Num() + AdditionalRecipeClasses.Num());
+
+		for (const auto& ClassName : DerivedClassNames)
+		{
+			// Skip temporary classes generated by blueprint compilation
+
+			const auto AssetName{ ClassName.GetAssetName().ToString() };
+
+			if (AssetName.StartsWith(TEXT("SKEL_")) || AssetName.StartsWith(TEXT("REINST_")))
+			{
+				continue;
+			}
+
+			FoundClasses.Emplace(ClassName.ToString());
+		}
+
+		// Classes stripped from CharacterSets in dedicated server cooks are not cooked, but the client still has them
+
+		TArray<FAssetData> CharacterSetAssets;
+		AssetRegistryModule->Get().GetAssetsByClass(UCharacterSet::StaticClass()->GetClassPathName(), CharacterSetAssets, true);
+
+		for (const auto& AssetData : CharacterSetAssets)
+		{
+			FString StrippedClassPaths;
+
+			if (AssetData.GetTagValue(UCharacterSet::NAME_StrippedRecipesTag, StrippedClassPaths))
+			{
+				TArray<FString> ClassPaths;
+				StrippedClassPaths.ParseIntoArray(ClassPaths, TEXT(","));
+
+				for (const auto& ClassPath : ClassPaths)
+				{
+					FoundClasses.Emplace(ClassPath);
+				}
+			}
+		}
+	}
+
+	for (const auto& ClassPath : AdditionalRecipeClasses)
+	{
+		if (ClassPath.IsValid())
+		{
+			FoundClasses.Emplace(ClassPath);
+		}
+	}
+
+	// Sort by path so that the index is deterministic regardless of the order of discovery
+
+	auto NewRecipeClasses{ FoundClasses.Array() };
+	NewRecipeClasses.Sort([](const FSoftClassPath& A, const FSoftClassPath& B) { return A.ToString() < B.ToString(); });
+
+	if (NewRecipeClasses == RecipeClasses)
+	{
+		return false;
+	}
+
+	RecipeClasses = MoveTemp(NewRecipeClasses);
+
+	RebuildCache();
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("CharacterRecipe registry built (Classes: %d, Checksum: %08X)"), RecipeClasses.Num(), Checksum);
+
+	return true;
+}
+
+void UCharacterRecipeRegistry::RebuildCache()
+{
+	ClassIndexMap.Reset();
+	ResolvedClasses.Reset();
+
+	if (RecipeClasses.Num() >= FCharacterRecipeClassIndex::INDEX_Invalid)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Too many CharacterRecipe classes are registered (%d). Classes after index %d cannot be replicated.")
+			, RecipeClasses.Num(), FCharacterRecipeClassIndex::INDEX_Invalid - 1);
+	}
+
+	const auto NumIndices{ FMath::Min<int32>(RecipeClasses.Num(), FCharacterRecipeClassIndex::INDEX_Invalid) };
+
+	ClassIndexMap.Reserve(NumIndices);
+	ResolvedClasses.SetNum(NumIndices);
+
+	auto NewChecksum{ static_cast<uint32>(NumIndices) };
+
+	for (auto Index{ 0 }; Index < NumIndices; ++Index)
+	{
+		const auto& ClassPath{ RecipeClasses[Index] };
+
+		ClassIndexMap.Add(ClassPath, static_cast<uint16>(Index));
+
+		NewChecksum = FCrc::StrCrc32(*ClassPath.ToString(), NewChecksum);
+	}
+
+	if (Checksum != NewChecksum)
+	{
+		Checksum = NewChecksum;
+
+		// The checksum is part of the network version, so the cached value needs to be recalculated
+
+		FNetworkVersion::InvalidateNetworkChecksum();
+	}
+}
+
+
+FCharacterRecipeClassIndex UCharacterRecipeRegistry::GetClassIndex(const UClass* InClass) const
+{
+	return InClass ? GetClassIndexByPath(FSoftClassPath(InClass)) : FCharacterRecipeClassIndex();
+}
+
+FCharacterRecipeClassIndex UCharacterRecipeRegistry::GetClassIndexByPath(const FSoftClassPath& InClassPath) const
+{
+	const auto* Index{ ClassIndexMap.Find(InClassPath) };
+
+	return Index ? FCharacterRecipeClassIndex(*Index) : FCharacterRecipeClassIndex();
+}
+
+TSubclassOf<UCharacterRecipe> UCharacterRecipeRegistry::ResolveClass(const FCharacterRecipeClassIndex& InIndex) const
+{
+	if (!ResolvedClasses.IsValidIndex(InIndex.GetIndex()))
+	{
+		return nullptr;
+	}
+
+	auto& ResolvedClass{ ResolvedClasses[InIndex.GetIndex()] };
+
+	if (!ResolvedClass.IsValid())
+	{
+		const auto& ClassPath{ RecipeClasses[InIndex.GetIndex()] };
+
+		auto* Class{ ClassPath.ResolveClass() };
+
+		if (!Class)
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("CharacterRecipe class (%s) is not loaded yet, loading synchronously"), *ClassPath.ToString());
+
+			Class = ClassPath.TryLoadClass<UCharacterRecipe>();
+		}
+
+		ResolvedClass = Class;
+	}
+
+	return ResolvedClass.Get();
+}
+
+#pragma endregion
@@ -0,0 +1,183 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Engine/DeveloperSettings.h"
+
+#include "CharacterRecipeRegistry.generated.h"
+
+class UCharacterRecipe;
+namespace UE::Net { struct FCharacterRecipeClassIndexNetSerializer; }
+
+
+/**
+ * Small index that points to a CharacterRecipe class registered in CharacterRecipeRegistry
+ *
+ * Tips:
+ *	Used for replication instead of the reference to the CharacterRecipe CDO
+ */
+USTRUCT(BlueprintType)
+struct GCEXT_API FCharacterRecipeClassIndex
+{
+	GENERATED_BODY()
+
+	friend struct UE::Net::FCharacterRecipeClassIndexNetSerializer;
+
+public:
+	FCharacterRecipeClassIndex() {}
+	explicit FCharacterRecipeClassIndex(uint16 InIndex) : Index(InIndex) {}
+
+	//
+	// Value indicating an index not registered in the registry
+	//
+	static constexpr uint16 INDEX_Invalid{ MAX_uint16 };
+
+private:
+	UPROPERTY()
+	uint16 Index{ INDEX_Invalid };
+
+public:
+	bool operator==(const FCharacterRecipeClassIndex& Other) const { return Index == Other.Index; }
+	bool operator!=(const FCharacterRecipeClassIndex& Other) const { return Index != Other.Index; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+public:
+	/**
+	 * True if this points to a registered class
+	 */
+	bool IsValid() const { return Index != INDEX_Invalid; }
+
+	/**
+	 * Returns raw index value
+	 */
+	uint16 GetIndex() const { return Index; }
+
+	/**
+	 * Return this index as string.
+	 */
+	FString ToString() const { return IsValid() ? FString::FromInt(Index) : TEXT("Invalid"); }
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FCharacterRecipeClassIndex> : public TStructOpsTypeTraitsBase2<FCharacterRecipeClassIndex>
+{
+	enum { WithNetSerializer = true };
+};
+
+
+/**
+ * Deterministic registry that assigns a small index to each CharacterRecipe class
+ *
+ * Tips:
+ *	The list is built at startup from the CharacterRecipe classes known to the AssetRegistry (the cooked AssetRegistry in packaged builds),
+ *	the classes stripped from CharacterSets in dedicated server cooks and AdditionalRecipeClasses,
+ *	and is sorted by class path so that the server and client built from the same content have the same indices.
+ *	Classes without an index are replicated by their class path instead.
+ *
+ * Note:
+ *	The checksum is combined into the network version by the GCExt module after engine init,
+ *	so server and client with different registries are rejected on connect.
+ */
+UCLASS(Config = "Game", DefaultConfig, meta = (DisplayName = "Character Recipe Registry"))
+class GCEXT_API UCharacterRecipeRegistry : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeRegistry();
+
+	virtual void PostReloadConfig(FProperty* PropertyThatWasLoaded) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/**
+	 * Returns the registry
+	 * 
+	 * Tips:
+	 *	The list of classes is built on the first call if it has not been built yet
+	 */
+	static const UCharacterRecipeRegistry* Get();
+
+protected:
+	//
+	// CharacterRecipe classes always registered in addition to the classes found in the AssetRegistry
+	// 
+	// Tips:
+	//	Add classes that are not cooked for every target (e.g. classes only referenced by client content)
+	//	so that the server and client have the same indices.
+	//
+	UPROPERTY(Config, EditAnywhere, Category = "Registry", meta = (MetaClass = "/Script/GCExt.CharacterRecipe"))
+	TArray<FSoftClassPath> AdditionalRecipeClasses;
+
+	//
+	// List of CharacterRecipe classes in the order of index
+	//
+	UPROPERTY(Transient, VisibleAnywhere, Category = "Registry")
+	TArray<FSoftClassPath> RecipeClasses;
+
+	//
+	// Whether RecipeClasses has been built
+	//
+	bool bRegistryBuilt{ false };
+
+	//
+	// Mapping list of class path and index
+	//
+	TMap<FSoftClassPath, uint16> ClassIndexMap;
+
+	//
+	// Cache of classes already resolved from index
+	//
+	mutable TArray<TWeakObjectPtr<UClass>> ResolvedClasses;
+
+	//
+	// Checksum of RecipeClasses
+	//
+	uint32 Checksum{ 0 };
+
+protected:
+	/**
+	 * Rebuild the mapping list and checksum from RecipeClasses
+	 */
+	void RebuildCache();
+
+public:
+	/**
+	 * Rebuild the list of CharacterRecipe classes from the AssetRegistry and AdditionalRecipeClasses
+	 * 
+	 * Tips:
+	 *	Only updated in memory. Called at startup and by the editor when CharacterRecipe classes are added or removed.
+	 *	Returns true if the list has changed.
+	 */
+	bool RebuildRegistry();
+
+public:
+	/**
+	 * Returns index of the specified CharacterRecipe class
+	 */
+	FCharacterRecipeClassIndex GetClassIndex(const UClass* InClass) const;
+
+	/**
+	 * Returns index of the CharacterRecipe class at the specified path without loading it
+	 */
+	FCharacterRecipeClassIndex GetClassIndexByPath(const FSoftClassPath& InClassPath) const;
+
+	/**
+	 * Returns CharacterRecipe class of the specified index
+	 *
+	 * Note:
+	 *	If the class is not loaded yet, it is loaded synchronously
+	 */
+	TSubclassOf<UCharacterRecipe> ResolveClass(const FCharacterRecipeClassIndex& InIndex) const;
+
+	/**
+	 * Returns checksum of the registered classes
+	 * 
+	 * Tips:
+	 *	Combined into the network version by the GCExt module
+	 */
+	uint32 GetChecksum() const { return Checksum; }
+
+};
@@ -0,0 +1,392 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipeSubsystem.h"
+
+#include "CharacterInitStateComponent.h"
+#include "Recipe/CharacterRecipe.h"
+#include "GCExtLogs.h"
+
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "HAL/IConsoleManager.h"
+#include "GameFramework/Pawn.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipeSubsystem)
+
+
+static float GCharacterRecipeSetupFrameBudgetMs{ 0.0f };
+static FAutoConsoleVariableRef CVarCharacterRecipeSetupFrameBudgetMs(
+	TEXT("gcext.Recipe.SetupFrameBudgetMs"),
+	GCharacterRecipeSetupFrameBudgetMs,
+	TEXT("Time budget per frame for starting the setup process of CharacterRecipes across all pawns (ms). 0 starts them immediately."),
+	ECVF_Default);
+
+static float GCharacterRecipeDeferSignificanceThreshold{ 0.0f };
+static FAutoConsoleVariableRef CVarCharacterRecipeDeferSignificanceThreshold(
+	TEXT("gcext.Recipe.DeferSignificanceThreshold"),
+	GCharacterRecipeDeferSignificanceThreshold,
+	TEXT("ClientOnly CharacterRecipes of simulated pawns with significance below this value are deferred until the significance rises. 0 disables deferral."),
+	ECVF_Default);
+
+static float GCharacterRecipeSignificanceUpdateInterval{ 0.5f };
+static FAutoConsoleVariableRef CVarCharacterRecipeSignificanceUpdateInterval(
+	TEXT("gcext.Recipe.SignificanceUpdateInterval"),
+	GCharacterRecipeSignificanceUpdateInterval,
+	TEXT("Interval to reevaluate the significance of pawns with deferred CharacterRecipes or significance listeners (seconds)."),
+	ECVF_Default);
+
+
+//////////////////////////////////////////////////////
+// FCharacterRecipeSubsystemTickFunction
+
+#pragma region FCharacterRecipeSubsystemTickFunction
+
+void FCharacterRecipeSubsystemTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->Tick(DeltaTime);
+	}
+}
+
+FString FCharacterRecipeSubsystemTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCharacterRecipeSubsystemTickFunction");
+}
+
+FName FCharacterRecipeSubsystemTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXTVIEW("CharacterRecipeSubsystem"));
+}
+
+#pragma endregion
+
+
+//////////////////////////////////////////////////////
+// UCharacterRecipeSubsystem
+
+#pragma region UCharacterRecipeSubsystem
+
+void UCharacterRecipeSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Target = this;
+	TickFunction.TickGroup = TG_PostUpdateWork;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.bAllowTickOnDedicatedServer = true;
+	TickFunction.bTickEvenWhenPaused = true;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UCharacterRecipeSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+
+	TickFunction.Target = nullptr;
+
+	ComponentsPendingFinish.Empty();
+	LocalSetupQueue.Empty();
+	RemoteSetupQueue.Empty();
+	ComponentsWithDeferredRecipes.Empty();
+	SignificanceListeners.Empty();
+	SignificanceDelegate.Unbind();
+
+	Super::Deinitialize();
+}
+
+bool UCharacterRecipeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+
+void UCharacterRecipeSubsystem::Tick(float DeltaTime)
+{
+	// Finish notifications first, so that the recipes waiting for them can start in this frame
+
+	DrainRecipeSetupFinishedQueue();
+	UpdateDeferredRecipes(DeltaTime);
+	UpdateSignificanceListeners(DeltaTime);
+	ProcessRecipeSetupQueue();
+}
+
+#pragma endregion
+
+
+#pragma region Recipe Finish Queue
+
+void UCharacterRecipeSubsystem::QueueRecipeSetupFinished(UCharacterInitStateComponent* Component, bool bFirstNotificationOfComponent)
+{
+	check(Component);
+
+	++NumFinishNotificationsQueued;
+
+	if (bFirstNotificationOfComponent)
+	{
+		ComponentsPendingFinish.Emplace(Component);
+	}
+}
+
+void UCharacterRecipeSubsystem::DrainRecipeSetupFinishedQueue()
+{
+	NumFinishNotificationsProcessed = NumFinishNotificationsQueued;
+	NumComponentsProcessed = ComponentsPendingFinish.Num();
+
+	NumFinishNotificationsQueued = 0;
+
+	if (ComponentsPendingFinish.IsEmpty())
+	{
+		return;
+	}
+
+	/**
+	 * Notifications added while draining are processed in the next frame
+	 */
+	auto Components{ MoveTemp(ComponentsPendingFinish) };
+	ComponentsPendingFinish.Reset();
+
+	for (const auto& WeakComponent : Components)
+	{
+		if (auto* Component{ WeakComponent.Get() })
+		{
+			Component->HandleQueuedRecipeSetupFinished();
+		}
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("Processed %d CharacterRecipe finish notifications of %d components"), NumFinishNotificationsProcessed, NumComponentsProcessed);
+}
+
+#pragma endregion
+
+
+#pragma region Recipe Setup Queue
+
+bool UCharacterRecipeSubsystem::IsSetupTimeSlicingEnabled()
+{
+	return GCharacterRecipeSetupFrameBudgetMs > 0.0f;
+}
+
+void UCharacterRecipeSubsystem::QueueRecipeSetup(UCharacterInitStateComponent* Component, const FActiveCharacterRecipeHandle& Handle, bool bLocallyControlled)
+{
+	check(Component);
+
+	auto& Queue{ bLocallyControlled ? LocalSetupQueue : RemoteSetupQueue };
+
+	Queue.Emplace(Component, Handle, FPlatformTime::Seconds());
+}
+
+void UCharacterRecipeSubsystem::ProcessRecipeSetupQueue()
+{
+	NumSetupsProcessed = 0;
+	MaxSetupWaitTimeMs = 0.0f;
+	SetupTimeMs = 0.0f;
+
+	if (LocalSetupQueue.IsEmpty() && RemoteSetupQueue.IsEmpty())
+	{
+		return;
+	}
+
+	const auto StartTime{ FPlatformTime::Seconds() };
+	const auto EndTime{ StartTime + (GCharacterRecipeSetupFrameBudgetMs / 1000.0) };
+
+	auto NumLocalProcessed{ 0 };
+	auto NumRemoteProcessed{ 0 };
+
+	/**
+	 * Requests added while processing (e.g. recipes whose prerequisites finished) are appended to the queues
+	 * and processed in this frame if the budget remains.
+	 * At least one request is processed per frame so that the queue always progresses.
+	 */
+	while (true)
+	{
+		const auto bHasLocal{ NumLocalProcessed < LocalSetupQueue.Num() };
+		const auto bHasRemote{ NumRemoteProcessed < RemoteSetupQueue.Num() };
+
+		if (!bHasLocal && !bHasRemote)
+		{
+			break;
+		}
+
+		const auto Now{ FPlatformTime::Seconds() };
+
+		if ((NumSetupsProcessed > 0) && (Now >= EndTime))
+		{
+			break;
+		}
+
+		const auto Request{ bHasLocal ? LocalSetupQueue[NumLocalProcessed++] : RemoteSetupQueue[NumRemoteProcessed++] };
+
+		const auto WaitTimeMs{ static_cast<float>((Now - Request.QueuedTime) * 1000.0) };
+		MaxSetupWaitTimeMs = FMath::Max(MaxSetupWaitTimeMs, WaitTimeMs);
+		AverageSetupWaitTimeMs = FMath::Lerp(AverageSetupWaitTimeMs, WaitTimeMs, 0.1f);
+
+		++NumSetupsProcessed;
+
+		if (auto* Component{ Request.Component.Get() })
+		{
+			Component->HandleQueuedRecipeSetup(Request.Handle);
+		}
+	}
+
+	LocalSetupQueue.RemoveAt(0, NumLocalProcessed, false);
+	RemoteSetupQueue.RemoveAt(0, NumRemoteProcessed, false);
+
+	SetupTimeMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("Processed %d CharacterRecipe setup requests in %.2fms (Remaining: %d, MaxWait: %.2fms)")
+		, NumSetupsProcessed, SetupTimeMs, GetSetupQueueDepth(), MaxSetupWaitTimeMs);
+}
+
+#pragma endregion
+
+
+#pragma region Significance
+
+float UCharacterRecipeSubsystem::GetPawnSignificance(const APawn* Pawn) const
+{
+	return (Pawn && SignificanceDelegate.IsBound()) ? SignificanceDelegate.Execute(Pawn) : 1.0f;
+}
+
+bool UCharacterRecipeSubsystem::ShouldDeferCosmeticRecipes(const APawn* Pawn) const
+{
+	if (!Pawn || !SignificanceDelegate.IsBound() || (GCharacterRecipeDeferSignificanceThreshold <= 0.0f))
+	{
+		return false;
+	}
+
+	// Only pawns simulated on this client are deferred
+
+	if (Pawn->GetLocalRole() != ROLE_SimulatedProxy)
+	{
+		return false;
+	}
+
+	return SignificanceDelegate.Execute(Pawn) < GCharacterRecipeDeferSignificanceThreshold;
+}
+
+void UCharacterRecipeSubsystem::RegisterDeferredRecipes(UCharacterInitStateComponent* Component)
+{
+	check(Component);
+
+	ComponentsWithDeferredRecipes.AddUnique(Component);
+}
+
+void UCharacterRecipeSubsystem::RegisterSignificanceListener(UCharacterRecipe* Recipe, APawn* Pawn)
+{
+	check(Recipe);
+
+	SignificanceListeners.Emplace(Recipe, Pawn);
+
+	Recipe->HandleSignificanceUpdated(GetPawnSignificance(Pawn));
+}
+
+void UCharacterRecipeSubsystem::UnregisterSignificanceListener(UCharacterRecipe* Recipe)
+{
+	SignificanceListeners.RemoveAllSwap([Recipe](const FCharacterRecipeSignificanceListener& Listener) { return Listener.Recipe == Recipe; });
+}
+
+void UCharacterRecipeSubsystem::NotifySignificanceChanged(APawn* Pawn)
+{
+	if (!Pawn)
+	{
+		return;
+	}
+
+	for (const auto& Listener : SignificanceListeners)
+	{
+		if (Listener.Pawn == Pawn)
+		{
+			if (auto* Recipe{ Listener.Recipe.Get() })
+			{
+				Recipe->HandleSignificanceUpdated(GetPawnSignificance(Pawn));
+			}
+		}
+	}
+
+	if (ShouldDeferCosmeticRecipes(Pawn))
+	{
+		return;
+	}
+
+	if (auto* Component{ Pawn->FindComponentByClass<UCharacterInitStateComponent>() })
+	{
+		if (ComponentsWithDeferredRecipes.RemoveSwap(Component) > 0)
+		{
+			Component->ResumeDeferredRecipes();
+		}
+	}
+}
+
+void UCharacterRecipeSubsystem::UpdateDeferredRecipes(float DeltaTime)
+{
+	if (ComponentsWithDeferredRecipes.IsEmpty())
+	{
+		return;
+	}
+
+	TimeUntilSignificanceUpdate -= DeltaTime;
+
+	if (TimeUntilSignificanceUpdate > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilSignificanceUpdate = GCharacterRecipeSignificanceUpdateInterval;
+
+	for (auto Index{ ComponentsWithDeferredRecipes.Num() - 1 }; Index >= 0; --Index)
+	{
+		auto* Component{ ComponentsWithDeferredRecipes[Index].Get() };
+
+		if (!Component)
+		{
+			ComponentsWithDeferredRecipes.RemoveAtSwap(Index, 1, false);
+		}
+		else if (!ShouldDeferCosmeticRecipes(Component->GetPawn<APawn>()))
+		{
+			ComponentsWithDeferredRecipes.RemoveAtSwap(Index, 1, false);
+
+			Component->ResumeDeferredRecipes();
+		}
+	}
+}
+
+void UCharacterRecipeSubsystem::UpdateSignificanceListeners(float DeltaTime)
+{
+	if (SignificanceListeners.IsEmpty() || !SignificanceDelegate.IsBound())
+	{
+		return;
+	}
+
+	TimeUntilListenerUpdate -= DeltaTime;
+
+	if (TimeUntilListenerUpdate > 0.0f)
+	{
+		return;
+	}
+
+	TimeUntilListenerUpdate = GCharacterRecipeSignificanceUpdateInterval;
+
+	for (auto Index{ SignificanceListeners.Num() - 1 }; Index >= 0; --Index)
+	{
+		const auto& Listener{ SignificanceListeners[Index] };
+
+		auto* Recipe{ Listener.Recipe.Get() };
+		auto* Pawn{ Listener.Pawn.Get() };
+
+		if (!Recipe || !Pawn)
+		{
+			SignificanceListeners.RemoveAtSwap(Index, 1, false);
+		}
+		else
+		{
+			Recipe->HandleSignificanceUpdated(GetPawnSignificance(Pawn));
+		}
+	}
+}
+
+#pragma endregion
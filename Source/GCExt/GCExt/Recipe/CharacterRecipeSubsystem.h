@@ -0,0 +1,375 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+
+#include "Recipe/ActiveCharacterRecipeHandle.h"
+
+#include "CharacterRecipeSubsystem.generated.h"
+
+class UCharacterRecipeSubsystem;
+class UCharacterInitStateComponent;
+class UCharacterRecipe;
+class APawn;
+
+
+/**
+ * Delegate that returns the significance of the pawn
+ * 
+ * Tips:
+ *	ClientOnly CharacterRecipes of simulated pawns whose significance is below "gcext.Recipe.DeferSignificanceThreshold" are deferred
+ */
+DECLARE_DELEGATE_RetVal_OneParam(float, FCharacterRecipeSignificanceDelegate, const APawn*);
+
+
+/**
+ * Tick function that drains the queues of CharacterRecipeSubsystem once per frame
+ */
+USTRUCT()
+struct FCharacterRecipeSubsystemTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+public:
+	FCharacterRecipeSubsystemTickFunction() {}
+
+public:
+	//
+	// Subsystem that is the target of this tick
+	//
+	UCharacterRecipeSubsystem* Target{ nullptr };
+
+public:
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FCharacterRecipeSubsystemTickFunction> : public TStructOpsTypeTraitsBase2<FCharacterRecipeSubsystemTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+
+/**
+ * Request to start the setup process of a CharacterRecipe waiting in the setup queue
+ */
+struct FCharacterRecipeSetupRequest
+{
+public:
+	FCharacterRecipeSetupRequest() {}
+	FCharacterRecipeSetupRequest(UCharacterInitStateComponent* InComponent, const FActiveCharacterRecipeHandle& InHandle, double InQueuedTime)
+		: Component(InComponent), Handle(InHandle), QueuedTime(InQueuedTime)
+	{}
+
+public:
+	TWeakObjectPtr<UCharacterInitStateComponent> Component;
+
+	FActiveCharacterRecipeHandle Handle;
+
+	double QueuedTime{ 0.0 };
+
+};
+
+
+/**
+ * Instanced CharacterRecipe that is notified when the significance of its pawn is reevaluated
+ */
+struct FCharacterRecipeSignificanceListener
+{
+public:
+	FCharacterRecipeSignificanceListener() {}
+	FCharacterRecipeSignificanceListener(UCharacterRecipe* InRecipe, APawn* InPawn)
+		: Recipe(InRecipe), Pawn(InPawn)
+	{}
+
+public:
+	TWeakObjectPtr<UCharacterRecipe> Recipe;
+
+	TWeakObjectPtr<APawn> Pawn;
+
+};
+
+
+/**
+ * World subsystem that batches CharacterRecipe processing of all pawns in the world
+ *
+ * Tips:
+ *	Finish notifications of CharacterRecipes from every CharacterInitStateComponent are collected into one queue
+ *	and drained once per frame at TG_PostUpdateWork.
+ *	If "gcext.Recipe.SetupFrameBudgetMs" is greater than 0, the setup process of CharacterRecipes is also queued
+ *	and time-sliced across frames within the budget, serving locally controlled pawns first.
+ */
+UCLASS()
+class GCEXT_API UCharacterRecipeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	friend struct FCharacterRecipeSubsystemTickFunction;
+
+public:
+	UCharacterRecipeSubsystem() {}
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+protected:
+	//
+	// Tick function to drain the queues
+	//
+	FCharacterRecipeSubsystemTickFunction TickFunction;
+
+protected:
+	/**
+	 * Drain the queues once per frame
+	 */
+	virtual void Tick(float DeltaTime);
+
+
+	/////////////////////////////////////////////////////////////////
+	// Recipe Finish Queue
+#pragma region Recipe Finish Queue
+protected:
+	//
+	// List of components that have CharacterRecipe finish notifications pending
+	//
+	TArray<TWeakObjectPtr<UCharacterInitStateComponent>> ComponentsPendingFinish;
+
+	//
+	// Number of finish notifications queued since the last drain
+	//
+	int32 NumFinishNotificationsQueued{ 0 };
+
+	//
+	// Number of finish notifications processed in the last drain
+	//
+	int32 NumFinishNotificationsProcessed{ 0 };
+
+	//
+	// Number of components processed in the last drain
+	//
+	int32 NumComponentsProcessed{ 0 };
+
+public:
+	/**
+	 * Add a finish notification of CharacterRecipe to the queue
+	 *
+	 * Tips:
+	 *	The component is queued only once per frame regardless of the number of notifications.
+	 */
+	void QueueRecipeSetupFinished(UCharacterInitStateComponent* Component, bool bFirstNotificationOfComponent);
+
+	/**
+	 * Returns number of finish notifications processed in the last frame
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumFinishNotificationsProcessed() const { return NumFinishNotificationsProcessed; }
+
+	/**
+	 * Returns number of components processed in the last frame
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumComponentsProcessed() const { return NumComponentsProcessed; }
+
+protected:
+	/**
+	 * Process all queued finish notifications
+	 */
+	void DrainRecipeSetupFinishedQueue();
+
+#pragma endregion
+
+
+	/////////////////////////////////////////////////////////////////
+	// Recipe Setup Queue
+#pragma region Recipe Setup Queue
+protected:
+	//
+	// Setup requests of locally controlled pawns
+	//
+	TArray<FCharacterRecipeSetupRequest> LocalSetupQueue;
+
+	//
+	// Setup requests of other pawns
+	//
+	TArray<FCharacterRecipeSetupRequest> RemoteSetupQueue;
+
+	//
+	// Number of setup requests processed in the last frame
+	//
+	int32 NumSetupsProcessed{ 0 };
+
+	//
+	// Longest time a request processed in the last frame waited in the queue (ms)
+	//
+	float MaxSetupWaitTimeMs{ 0.0f };
+
+	//
+	// Moving average of the time requests waited in the queue (ms)
+	//
+	float AverageSetupWaitTimeMs{ 0.0f };
+
+	//
+	// Time spent on setup processing in the last frame (ms)
+	//
+	float SetupTimeMs{ 0.0f };
+
+public:
+	/**
+	 * Returns whether the setup process is time-sliced by the frame budget
+	 */
+	static bool IsSetupTimeSlicingEnabled();
+
+	/**
+	 * Add a setup request of CharacterRecipe to the queue
+	 */
+	void QueueRecipeSetup(UCharacterInitStateComponent* Component, const FActiveCharacterRecipeHandle& Handle, bool bLocallyControlled);
+
+	/**
+	 * Returns number of setup requests waiting in the queue
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetSetupQueueDepth() const { return LocalSetupQueue.Num() + RemoteSetupQueue.Num(); }
+
+	/**
+	 * Returns number of setup requests processed in the last frame
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumSetupsProcessed() const { return NumSetupsProcessed; }
+
+	/**
+	 * Returns longest time a request processed in the last frame waited in the queue (ms)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	float GetMaxSetupWaitTimeMs() const { return MaxSetupWaitTimeMs; }
+
+	/**
+	 * Returns moving average of the time requests waited in the queue (ms)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	float GetAverageSetupWaitTimeMs() const { return AverageSetupWaitTimeMs; }
+
+	/**
+	 * Returns time spent on setup processing in the last frame (ms)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	float GetSetupTimeMs() const { return SetupTimeMs; }
+
+protected:
+	/**
+	 * Process queued setup requests within the frame budget
+	 */
+	void ProcessRecipeSetupQueue();
+
+#pragma endregion
+
+
+	/////////////////////////////////////////////////////////////////
+	// Significance
+#pragma region Significance
+protected:
+	//
+	// Delegate to get the significance of the pawn
+	// 
+	// Tips:
+	//	If not bound, no CharacterRecipe is deferred
+	//
+	FCharacterRecipeSignificanceDelegate SignificanceDelegate;
+
+	//
+	// List of components that have deferred CharacterRecipes
+	//
+	TArray<TWeakObjectPtr<UCharacterInitStateComponent>> ComponentsWithDeferredRecipes;
+
+	//
+	// Remaining time until the next significance update of the components with deferred CharacterRecipes
+	//
+	float TimeUntilSignificanceUpdate{ 0.0f };
+
+	//
+	// List of CharacterRecipe instances notified when the significance of their pawn is reevaluated
+	//
+	TArray<FCharacterRecipeSignificanceListener> SignificanceListeners;
+
+	//
+	// Remaining time until the next significance update of the listeners
+	//
+	float TimeUntilListenerUpdate{ 0.0f };
+
+public:
+	/**
+	 * Set the delegate to get the significance of the pawn
+	 */
+	void SetSignificanceDelegate(FCharacterRecipeSignificanceDelegate InDelegate) { SignificanceDelegate = MoveTemp(InDelegate); }
+
+	/**
+	 * Returns significance of the pawn
+	 * 
+	 * Tips:
+	 *	Returns 1.0 if the delegate is not bound
+	 */
+	float GetPawnSignificance(const APawn* Pawn) const;
+
+	/**
+	 * Returns whether ClientOnly CharacterRecipes of the pawn should be deferred
+	 */
+	bool ShouldDeferCosmeticRecipes(const APawn* Pawn) const;
+
+	/**
+	 * Register the CharacterRecipe instance to be notified of the significance of the pawn
+	 * 
+	 * Tips:
+	 *	The current significance is notified immediately, and then every "gcext.Recipe.SignificanceUpdateInterval" seconds
+	 */
+	void RegisterSignificanceListener(UCharacterRecipe* Recipe, APawn* Pawn);
+
+	/**
+	 * Unregister the CharacterRecipe instance registered by RegisterSignificanceListener()
+	 */
+	void UnregisterSignificanceListener(UCharacterRecipe* Recipe);
+
+	/**
+	 * Register the component that has deferred CharacterRecipes
+	 */
+	void RegisterDeferredRecipes(UCharacterInitStateComponent* Component);
+
+	/**
+	 * Notify that the significance of the pawn has changed
+	 * 
+	 * Tips:
+	 *	Applies the deferred CharacterRecipes of the pawn if needed and notifies its listeners.
+	 */
+	void NotifySignificanceChanged(APawn* Pawn);
+
+	/**
+	 * Returns number of components that have deferred CharacterRecipes
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumComponentsWithDeferredRecipes() const { return ComponentsWithDeferredRecipes.Num(); }
+
+	/**
+	 * Returns number of CharacterRecipe instances notified of the significance of their pawn
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Recipes")
+	int32 GetNumSignificanceListeners() const { return SignificanceListeners.Num(); }
+
+protected:
+	/**
+	 * Periodically reevaluate the significance of the components with deferred CharacterRecipes
+	 */
+	void UpdateDeferredRecipes(float DeltaTime);
+
+	/**
+	 * Periodically notify the listeners of the significance of their pawn
+	 */
+	void UpdateSignificanceListeners(float DeltaTime);
+
+#pragma endregion
+
+};
@@ -0,0 +1,203 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipe_AnimationLOD.h"
+
+#include "Recipe/CharacterRecipeSubsystem.h"
+#include "CharacterInitStateComponent.h"
+#include "GCExtLogs.h"
+
+#include "GameFramework/Pawn.h"
+#include "Components/SkeletalMeshComponent.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe_AnimationLOD)
+
+
+UCharacterRecipe_AnimationLOD::UCharacterRecipe_AnimationLOD()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::Both;
+	bAllowInstancePooling = true;
+
+#if WITH_EDITOR
+	StaticClass()->FindPropertyByName(FName{ TEXTVIEW("InstancingPolicy") })->SetPropertyFlags(CPF_DisableEditOnTemplate);
+#endif
+}
+
+
+void UCharacterRecipe_AnimationLOD::StartSetup_Implementation(const FCharacterRecipePawnInfo& Info)
+{
+	auto* InitStateComponent{ Info.InitStateComponent.Get() };
+
+	if (!InitStateComponent)
+	{
+		FinishSetup();
+		return;
+	}
+
+	auto* LeaderMesh{ InitStateComponent->GetMeshByTag(LeaderMeshTag) };
+
+	if (LeaderMesh)
+	{
+		AddMesh(LeaderMesh);
+
+		for (const auto& FollowerMeshTag : FollowerMeshTags)
+		{
+			auto* FollowerMesh{ InitStateComponent->GetMeshByTag(FollowerMeshTag) };
+
+			if (FollowerMesh && (FollowerMesh != LeaderMesh))
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Set Leader Pose (Follower: %s, Leader: %s)"), *GetNameSafe(FollowerMesh), *GetNameSafe(LeaderMesh));
+
+				auto& FollowerEntry{ AddMesh(FollowerMesh) };
+				FollowerEntry.bChangedLeaderPose = true;
+				FollowerEntry.OriginalLeaderPoseComponent = FollowerMesh->LeaderPoseComponent;
+
+				FollowerMesh->SetLeaderPoseComponent(LeaderMesh);
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("+Leader mesh not found (Tag: %s)"), *LeaderMeshTag.ToString());
+	}
+
+	// Apply the level for the current significance and follow its changes
+
+	if (!Levels.IsEmpty() && !Meshes.IsEmpty())
+	{
+		if (auto* Subsystem{ UWorld::GetSubsystem<UCharacterRecipeSubsystem>(Info.Pawn->GetWorld()) })
+		{
+			Subsystem->RegisterSignificanceListener(this, Info.Pawn.Get());
+		}
+		else
+		{
+			HandleSignificanceUpdated(1.0f);
+		}
+	}
+
+	FinishSetup();
+}
+
+void UCharacterRecipe_AnimationLOD::OnDestroy_Implementation()
+{
+	auto* Pawn{ PawnInfo.Pawn.Get() };
+
+	if (auto* Subsystem{ Pawn ? UWorld::GetSubsystem<UCharacterRecipeSubsystem>(Pawn->GetWorld()) : nullptr })
+	{
+		Subsystem->UnregisterSignificanceListener(this);
+	}
+
+	RestoreMeshes();
+}
+
+void UCharacterRecipe_AnimationLOD::ResetForPool_Implementation()
+{
+	RestoreMeshes();
+
+	CurrentLevelIndex = INDEX_NONE;
+}
+
+
+void UCharacterRecipe_AnimationLOD::HandleSignificanceUpdated(float Significance)
+{
+	const auto NewLevelIndex{ FindLevelIndex(Significance) };
+
+	// Only apply when the level changes to avoid touching the meshes every update
+
+	if ((NewLevelIndex != CurrentLevelIndex) && Levels.IsValidIndex(NewLevelIndex))
+	{
+		CurrentLevelIndex = NewLevelIndex;
+
+		ApplyLevel(Levels[NewLevelIndex]);
+	}
+}
+
+int32 UCharacterRecipe_AnimationLOD::FindLevelIndex(float Significance) const
+{
+	auto BestIndex{ INDEX_NONE };
+
+	for (auto Index{ 0 }; Index < Levels.Num(); ++Index)
+	{
+		const auto& Level{ Levels[Index] };
+
+		if ((Level.MinSignificance <= Significance) && (!Levels.IsValidIndex(BestIndex) || (Level.MinSignificance > Levels[BestIndex].MinSignificance)))
+		{
+			BestIndex = Index;
+		}
+	}
+
+	// Use the lowest level if the significance is below all levels
+
+	if (BestIndex == INDEX_NONE)
+	{
+		for (auto Index{ 0 }; Index < Levels.Num(); ++Index)
+		{
+			if (!Levels.IsValidIndex(BestIndex) || (Levels[Index].MinSignificance < Levels[BestIndex].MinSignificance))
+			{
+				BestIndex = Index;
+			}
+		}
+	}
+
+	return BestIndex;
+}
+
+void UCharacterRecipe_AnimationLOD::ApplyLevel(const FCharacterAnimationLODLevel& Level)
+{
+	UE_LOG(LogGameExt_CharacterRecipe, Verbose, TEXT("| [%s][Instanced] Apply Animation LOD (Level: %d, URO: %d, TickInterval: %.3f)")
+		, *PawnInfo.Handle.ToString(), CurrentLevelIndex, Level.bEnableUpdateRateOptimizations, Level.TickInterval);
+
+	for (const auto& Entry : Meshes)
+	{
+		if (auto* Mesh{ Entry.Mesh.Get() })
+		{
+			Mesh->bEnableUpdateRateOptimizations = Level.bEnableUpdateRateOptimizations;
+			Mesh->VisibilityBasedAnimTickOption = Level.VisibilityBasedAnimTickOption;
+			Mesh->SetComponentTickInterval(Level.TickInterval);
+		}
+	}
+}
+
+FCharacterAnimationLODMesh& UCharacterRecipe_AnimationLOD::AddMesh(USkeletalMeshComponent* Mesh)
+{
+	auto& NewEntry{ Meshes.AddDefaulted_GetRef() };
+	NewEntry.Mesh = Mesh;
+	NewEntry.bOriginalEnableUpdateRateOptimizations = Mesh->bEnableUpdateRateOptimizations;
+	NewEntry.OriginalTickInterval = Mesh->GetComponentTickInterval();
+	NewEntry.OriginalVisibilityBasedAnimTickOption = Mesh->VisibilityBasedAnimTickOption;
+
+	return NewEntry;
+}
+
+void UCharacterRecipe_AnimationLOD::RestoreMeshes()
+{
+	// Only the meshes whose level was applied have their update settings changed
+
+	const auto bLevelApplied{ CurrentLevelIndex != INDEX_NONE };
+
+	for (const auto& Entry : Meshes)
+	{
+		auto* Mesh{ Entry.Mesh.Get() };
+
+		if (!Mesh)
+		{
+			continue;
+		}
+
+		if (Entry.bChangedLeaderPose)
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("-Restore Leader Pose (Follower: %s)"), *GetNameSafe(Mesh));
+
+			Mesh->SetLeaderPoseComponent(Entry.OriginalLeaderPoseComponent.Get());
+		}
+
+		if (bLevelApplied)
+		{
+			Mesh->bEnableUpdateRateOptimizations = Entry.bOriginalEnableUpdateRateOptimizations;
+			Mesh->VisibilityBasedAnimTickOption = Entry.OriginalVisibilityBasedAnimTickOption;
+			Mesh->SetComponentTickInterval(Entry.OriginalTickInterval);
+		}
+	}
+
+	Meshes.Reset();
+}
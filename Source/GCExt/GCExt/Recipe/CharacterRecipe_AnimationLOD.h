@@ -0,0 +1,182 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipe.h"
+
+#include "Components/SkinnedMeshComponent.h"
+
+#include "CharacterRecipe_AnimationLOD.generated.h"
+
+class USkeletalMeshComponent;
+class USkinnedMeshComponent;
+
+
+/**
+ * Animation update settings applied while the significance of the pawn is above the threshold
+ */
+USTRUCT(BlueprintType)
+struct FCharacterAnimationLODLevel
+{
+	GENERATED_BODY()
+public:
+	FCharacterAnimationLODLevel() {}
+
+public:
+	//
+	// Minimum significance to use this level
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = 0.0))
+	float MinSignificance{ 0.0f };
+
+	//
+	// Whether to enable update rate optimizations (URO) of the meshes
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	bool bEnableUpdateRateOptimizations{ false };
+
+	//
+	// Tick interval of the meshes (seconds)
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = 0.0))
+	float TickInterval{ 0.0f };
+
+	//
+	// Whether to tick the pose and refresh the bones of the meshes when not rendered
+	//
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EVisibilityBasedAnimTickOption VisibilityBasedAnimTickOption{ EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones };
+
+};
+
+
+/**
+ * Mesh controlled by the animation LOD and its settings before the CharacterRecipe was applied
+ */
+USTRUCT()
+struct FCharacterAnimationLODMesh
+{
+	GENERATED_BODY()
+public:
+	FCharacterAnimationLODMesh() {}
+
+public:
+	//
+	// Mesh to which the level is applied
+	//
+	UPROPERTY(Transient)
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+
+	//
+	// Whether the leader pose component of the mesh was changed
+	//
+	UPROPERTY(Transient)
+	bool bChangedLeaderPose{ false };
+
+	//
+	// Leader pose component of the mesh before it was changed
+	//
+	UPROPERTY(Transient)
+	TWeakObjectPtr<USkinnedMeshComponent> OriginalLeaderPoseComponent;
+
+	//
+	// Update rate optimizations (URO) setting of the mesh before the level was applied
+	//
+	UPROPERTY(Transient)
+	bool bOriginalEnableUpdateRateOptimizations{ false };
+
+	//
+	// Tick interval of the mesh before the level was applied
+	//
+	UPROPERTY(Transient)
+	float OriginalTickInterval{ 0.0f };
+
+	//
+	// Visibility based anim tick option of the mesh before the level was applied
+	//
+	UPROPERTY(Transient)
+	EVisibilityBasedAnimTickOption OriginalVisibilityBasedAnimTickOption{ EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones };
+
+};
+
+
+/**
+ * Recipe class to make secondary meshes follow the pose of a leader mesh and scale animation cost with significance
+ *
+ * Tips:
+ *	Follower meshes copy the pose of the leader instead of evaluating their own animation,
+ *	and the update rate of the leader and followers is changed according to the significance of the pawn
+ *	returned by the significance delegate of CharacterRecipeSubsystem.
+ *	The original leader pose and update settings of the meshes are restored when the CharacterRecipe is destroyed.
+ */
+UCLASS()
+class UCharacterRecipe_AnimationLOD final : public UCharacterRecipe
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_AnimationLOD();
+
+protected:
+	//
+	// Tag of the mesh that evaluates the animation
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation LOD", meta = (Categories = "MeshType"))
+	FGameplayTag LeaderMeshTag;
+
+	//
+	// Tags of the meshes that follow the pose of the leader mesh
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation LOD", meta = (Categories = "MeshType"))
+	TArray<FGameplayTag> FollowerMeshTags;
+
+	//
+	// Settings for each significance level
+	//
+	// Tips:
+	//	The level with the highest MinSignificance not above the significance of the pawn is used.
+	//	If empty, the update settings of the meshes are not changed.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation LOD")
+	TArray<FCharacterAnimationLODLevel> Levels;
+
+	//
+	// Index of the level currently applied
+	//
+	int32 CurrentLevelIndex{ INDEX_NONE };
+
+	//
+	// Meshes to which the level is applied
+	//
+	UPROPERTY(Transient)
+	TArray<FCharacterAnimationLODMesh> Meshes;
+
+protected:
+	virtual void StartSetup_Implementation(const FCharacterRecipePawnInfo& Info) override;
+	virtual void OnDestroy_Implementation() override;
+	virtual void ResetForPool_Implementation() override;
+
+public:
+	virtual void HandleSignificanceUpdated(float Significance) override;
+
+protected:
+	/**
+	 * Returns index of the level for the significance
+	 */
+	int32 FindLevelIndex(float Significance) const;
+
+	/**
+	 * Apply the level to the meshes
+	 */
+	void ApplyLevel(const FCharacterAnimationLODLevel& Level);
+
+	/**
+	 * Add the mesh to which the level is applied, saving its current settings
+	 */
+	FCharacterAnimationLODMesh& AddMesh(USkeletalMeshComponent* Mesh);
+
+	/**
+	 * Restore the settings of the meshes saved when they were added and stop controlling them
+	 */
+	void RestoreMeshes();
+
+};
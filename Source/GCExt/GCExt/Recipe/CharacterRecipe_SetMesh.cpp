@@ -3,13 +3,10 @@
 #include "CharacterRecipe_SetMesh.h"
 
 #include "CharacterInitStateComponent.h"
+#include "CharacterBakedBuild.h"
 #include "GCExtLogs.h"
 
-#include "Character/CharacterMeshAccessorInterface.h"
-
-#include "GameFramework/Pawn.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "Animation/AnimInstance.h"
+#include "Engine/AssetManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe_SetMesh)
 
@@ -18,6 +15,7 @@ UCharacterRecipe_SetMesh::UCharacterRecipe_SetMesh()
 {
 	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
 	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::Both;
+	bSupportsBuildOutputCache = true;
 
 #if WITH_EDITOR
 	StaticClass()->FindPropertyByName(FName{ TEXTVIEW("InstancingPolicy") })->SetPropertyFlags(CPF_DisableEditOnTemplate);
@@ -28,68 +26,192 @@ UCharacterRecipe_SetMesh::UCharacterRecipe_SetMesh()
 
 void UCharacterRecipe_SetMesh::StartSetupNonInstanced_Implementation(FCharacterRecipePawnInfo Info) const
 {
+	if (bLoadAsync)
+	{
+		RequestAsyncLoad(Info);
+	}
+	else
+	{
+		ApplyMeshesToSetMesh(Info, MeshesToSetMesh);
+	}
+}
+
+void UCharacterRecipe_SetMesh::ApplyMeshesToSetMesh(const FCharacterRecipePawnInfo& Info, TConstArrayView<FMeshToSetMesh> InMeshesToSetMesh) const
+{
+	// Staged so that entries and CharacterRecipes targeting the same mesh are committed at once
+
+	if (Info.InitStateComponent.IsValid())
+	{
+		Info.InitStateComponent->StageMeshChanges(InMeshesToSetMesh);
+	}
+	else
+	{
+		FMeshToSetMesh::ApplyToPawn(Info.Pawn.Get(), InMeshesToSetMesh);
+	}
+}
+
+
+#pragma region Build Output Cache
+
+UCharacterRecipeBuildOutput* UCharacterRecipe_SetMesh::CreateBuildOutput(UObject* Outer, const FCharacterRecipePawnInfo& Info) const
+{
+	auto* NewOutput{ NewObject<UCharacterRecipeBuildOutput_SetMesh>(Outer) };
+	NewOutput->MeshesToSetMesh = MeshesToSetMesh;
+
 	for (const auto& MeshToSet : MeshesToSetMesh)
 	{
-		if (auto* Mesh{ ICharacterMeshAccessorInterface::Execute_GetMeshByTag(Info.Pawn.Get(), MeshToSet.MeshTag)})
+		if (MeshToSet.bShouldChangeMesh && MeshToSet.SkeletalMesh.IsValid())
 		{
-			UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Modify Mesh (Name: %s)"), *GetNameSafe(Mesh));
+			NewOutput->ResolvedAssets.AddUnique(MeshToSet.SkeletalMesh.Get());
+		}
 
-			// Change Mesh
+		if (MeshToSet.bShouldChangeAnimInstance && MeshToSet.AnimInstance.IsValid())
+		{
+			NewOutput->ResolvedAssets.AddUnique(MeshToSet.AnimInstance.Get());
+		}
+	}
 
-			if (MeshToSet.bShouldChangeMesh)
-			{
-				auto* LoadedSkeltalMesh
-				{
-					MeshToSet.SkeletalMesh.IsNull() ? nullptr :
-					MeshToSet.SkeletalMesh.IsValid() ? MeshToSet.SkeletalMesh.Get() : MeshToSet.SkeletalMesh.LoadSynchronous()
-				};
+	return NewOutput;
+}
 
-				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SkeltalMesh (Name: %s)"), *GetNameSafe(LoadedSkeltalMesh));
+void UCharacterRecipe_SetMesh::ApplyBuildOutput(const FCharacterRecipePawnInfo& Info, const UCharacterRecipeBuildOutput* Output) const
+{
+	// Assets are held by the output, so they are applied without waiting for loading
 
-				Mesh->SetSkeletalMesh(LoadedSkeltalMesh);
-			}
+	if (const auto* SetMeshOutput{ Cast<UCharacterRecipeBuildOutput_SetMesh>(Output) })
+	{
+		ApplyMeshesToSetMesh(Info, SetMeshOutput->MeshesToSetMesh);
+	}
+}
 
-			// Change AnimInstance
+#pragma endregion
 
-			if (MeshToSet.bShouldChangeAnimInstance)
-			{
-				auto* LoadedAnimInstanceClass
-				{
-					MeshToSet.AnimInstance.IsNull() ? nullptr :
-					MeshToSet.AnimInstance.IsValid() ? MeshToSet.AnimInstance.Get() : MeshToSet.AnimInstance.LoadSynchronous()
-				};
 
-				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++AnimInstance (Name: %s)"), *GetNameSafe(LoadedAnimInstanceClass));
+#pragma region Baked Build
 
-				Mesh->SetAnimInstanceClass(LoadedAnimInstanceClass);
-			}
+#if WITH_EDITOR
+void UCharacterRecipe_SetMesh::BakeBuild(UCharacterBakedBuild* BakedBuild) const
+{
+	for (const auto& MeshToSet : MeshesToSetMesh)
+	{
+		BakedBuild->MergeMeshSettings(MeshToSet);
+	}
+}
+#endif
+
+#pragma endregion
+
+
+#pragma region Async Loading
 
-			// Change Location
+void UCharacterRecipe_SetMesh::RequestAsyncLoad(const FCharacterRecipePawnInfo& Info) const
+{
+	// Apply immediately if all assets are already resident
 
-			if (MeshToSet.bShouldChangeLocation)
-			{
-				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SetLocation (%s)"), *MeshToSet.NewLocation.ToString());
+	if (AreAllAssetsLoaded())
+	{
+		ApplyMeshesToSetMesh(Info, MeshesToSetMesh);
+		FinishSetupNonInstanced(Info);
+		return;
+	}
 
-				Mesh->SetRelativeLocation(MeshToSet.NewLocation);
-			}
+	PawnsWaitingForStreaming.Emplace(Info);
 
-			// Change Rotation
+	// Locally controlled pawns are loaded with higher priority than simulated proxies
 
-			if (MeshToSet.bShouldChangeRotation)
-			{
-				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SetRotation (%s)"), *MeshToSet.NewRotation.ToString());
+	const auto bLocallyControlled{ Info.Pawn.IsValid() && Info.Pawn->IsLocallyControlled() };
+	const auto Priority{ bLocallyControlled ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority };
 
-				Mesh->SetRelativeRotation(MeshToSet.NewRotation);
-			}
+	// Join the request already in flight for other pawns unless a higher priority is required
 
-			// Change Scale
+	if (StreamingHandle.IsValid() && StreamingHandle->IsLoadingInProgress() && (Priority <= StreamingPriority))
+	{
+		return;
+	}
 
-			if (MeshToSet.bShouldChangeScale)
-			{
-				UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SetScale (%s)"), *MeshToSet.NewScale.ToString());
+	TArray<FSoftObjectPath> AssetsToLoad;
+	GatherAssetsToLoad(AssetsToLoad);
 
-				Mesh->SetRelativeScale3D(MeshToSet.NewScale);
-			}
+	if (AssetsToLoad.IsEmpty())
+	{
+		HandleAsyncLoadCompleted();
+		return;
+	}
+
+	/**
+	 * If the request is issued again with a higher priority, 
+	 * the StreamableManager shares the assets already being loaded by the previous request.
+	 */
+	StreamingPriority = Priority;
+	StreamingHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		AssetsToLoad, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleAsyncLoadCompleted), Priority);
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Request Async Load (Num: %d, Priority: %d)"), AssetsToLoad.Num(), Priority);
+}
+
+void UCharacterRecipe_SetMesh::GatherAssetsToLoad(TArray<FSoftObjectPath>& OutAssetsToLoad) const
+{
+	for (const auto& MeshToSet : MeshesToSetMesh)
+	{
+		if (MeshToSet.bShouldChangeMesh && !MeshToSet.SkeletalMesh.IsNull())
+		{
+			OutAssetsToLoad.AddUnique(MeshToSet.SkeletalMesh.ToSoftObjectPath());
+		}
+
+		if (MeshToSet.bShouldChangeAnimInstance && !MeshToSet.AnimInstance.IsNull())
+		{
+			OutAssetsToLoad.AddUnique(MeshToSet.AnimInstance.ToSoftObjectPath());
+		}
+	}
+}
+
+void UCharacterRecipe_SetMesh::HandleAsyncLoadCompleted() const
+{
+	auto WaitingPawns{ MoveTemp(PawnsWaitingForStreaming) };
+	PawnsWaitingForStreaming.Reset();
+
+	for (const auto& Info : WaitingPawns)
+	{
+		// Skip pawns destroyed during loading
+
+		if (Info.Pawn.IsValid() && Info.InitStateComponent.IsValid())
+		{
+			ApplyMeshesToSetMesh(Info, MeshesToSetMesh);
+			FinishSetupNonInstanced(Info);
 		}
 	}
+
+	// The assets are now referenced by the meshes of the pawns
+
+	ReleaseStreamingHandle();
 }
+
+bool UCharacterRecipe_SetMesh::AreAllAssetsLoaded() const
+{
+	for (const auto& MeshToSet : MeshesToSetMesh)
+	{
+		if (MeshToSet.bShouldChangeMesh && !MeshToSet.SkeletalMesh.IsNull() && !MeshToSet.SkeletalMesh.IsValid())
+		{
+			return false;
+		}
+
+		if (MeshToSet.bShouldChangeAnimInstance && !MeshToSet.AnimInstance.IsNull() && !MeshToSet.AnimInstance.IsValid())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void UCharacterRecipe_SetMesh::ReleaseStreamingHandle() const
+{
+	if (StreamingHandle.IsValid() && PawnsWaitingForStreaming.IsEmpty())
+	{
+		StreamingHandle->ReleaseHandle();
+		StreamingHandle.Reset();
+		StreamingPriority = FStreamableManager::DefaultAsyncLoadPriority;
+	}
+}
+
+#pragma endregion
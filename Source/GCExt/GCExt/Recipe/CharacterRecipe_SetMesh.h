@@ -3,12 +3,45 @@
 #pragma once
 
 #include "Recipe/CharacterRecipe.h"
+#include "Recipe/CharacterRecipeBuildCache.h"
 
 #include "Recipe/CharacterSetMeshTypes.h"
 
+#include "Engine/StreamableManager.h"
+
 #include "CharacterRecipe_SetMesh.generated.h"
 
 
+/**
+ * Build output of CharacterRecipe_SetMesh
+ */
+UCLASS()
+class UCharacterRecipeBuildOutput_SetMesh final : public UCharacterRecipeBuildOutput
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipeBuildOutput_SetMesh() {}
+
+public:
+	//
+	// Settings of all entries applied to the meshes of the pawn
+	//
+	UPROPERTY()
+	TArray<FMeshToSetMesh> MeshesToSetMesh;
+
+	//
+	// SkeletalMeshes and AnimInstance classes resolved by the setup process
+	// 
+	// Tips:
+	//	Hard references so that the assets stay resident while the output is cached,
+	//	and pawns with the same build are set up synchronously even if bLoadAsync is enabled.
+	//
+	UPROPERTY()
+	TArray<TObjectPtr<UObject>> ResolvedAssets;
+
+};
+
+
 /**
  * Recipe class to Set mesh for Pawn
  */
@@ -23,7 +56,95 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Set Mesh")
 	TArray<FMeshToSetMesh> MeshesToSetMesh;
 
+	//
+	// Whether to load SkeletalMesh and AnimInstance asynchronously
+	// 
+	// Tips:
+	//	All soft references of all entries are requested in one batch and the setup finishes after every asset has arrived.
+	//	The request is shared with other pawns while it is in flight.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Set Mesh")
+	bool bLoadAsync{ false };
+
 protected:
 	virtual void StartSetupNonInstanced_Implementation(FCharacterRecipePawnInfo Info) const override;
+	virtual bool IsSetupNonInstancedAsync() const override { return bLoadAsync; }
+
+public:
+	virtual bool CanStartWithStagedMeshChanges() const override { return true; }
+
+protected:
+
+	/**
+	 * Apply the settings of all entries to the meshes of the pawn
+	 */
+	void ApplyMeshesToSetMesh(const FCharacterRecipePawnInfo& Info, TConstArrayView<FMeshToSetMesh> InMeshesToSetMesh) const;
+
+
+	/////////////////////////////////////////////////////////////////
+	// Build Output Cache
+public:
+	virtual UCharacterRecipeBuildOutput* CreateBuildOutput(UObject* Outer, const FCharacterRecipePawnInfo& Info) const override;
+
+protected:
+	virtual void ApplyBuildOutput(const FCharacterRecipePawnInfo& Info, const UCharacterRecipeBuildOutput* Output) const override;
+
+
+	/////////////////////////////////////////////////////////////////
+	// Baked Build
+#if WITH_EDITOR
+public:
+	virtual bool CanBakeBuild() const override { return true; }
+	virtual void BakeBuild(UCharacterBakedBuild* BakedBuild) const override;
+#endif
+
+
+	/////////////////////////////////////////////////////////////////
+	// Async Loading
+protected:
+	//
+	// Streamable handle of the request shared by all pawns
+	// 
+	// Tips:
+	//	Released when the load is complete and no pawns are waiting, so that the assets stay resident
+	//	only while they are used by meshes or held by other handles such as the preload of the CharacterSet.
+	//
+	mutable TSharedPtr<FStreamableHandle> StreamingHandle;
+
+	//
+	// Priority of the request currently in flight
+	//
+	mutable TAsyncLoadPriority StreamingPriority{ FStreamableManager::DefaultAsyncLoadPriority };
+
+	//
+	// List of pawns waiting for the request to complete
+	//
+	mutable TArray<FCharacterRecipePawnInfo> PawnsWaitingForStreaming;
+
+protected:
+	/**
+	 * Request to load all soft references of all entries or join the request already in flight
+	 */
+	void RequestAsyncLoad(const FCharacterRecipePawnInfo& Info) const;
+
+	/**
+	 * Collect soft references of all entries to be loaded
+	 */
+	void GatherAssetsToLoad(TArray<FSoftObjectPath>& OutAssetsToLoad) const;
+
+	/**
+	 * Returns whether all soft references of all entries are already loaded
+	 */
+	bool AreAllAssetsLoaded() const;
+
+	/**
+	 * Release the streamable handle if no pawns are waiting for it
+	 */
+	void ReleaseStreamingHandle() const;
+
+	/**
+	 * Executed when all requested assets have arrived
+	 */
+	void HandleAsyncLoadCompleted() const;
 
 };
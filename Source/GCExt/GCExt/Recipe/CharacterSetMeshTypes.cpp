@@ -2,4 +2,176 @@
 
 #include "CharacterSetMeshTypes.h"
 
+#include "CharacterInitStateComponent.h"
+#include "GCExtLogs.h"
+
+#include "Character/CharacterMeshAccessorInterface.h"
+
+#include "GameFramework/Pawn.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
+
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterSetMeshTypes)
+
+
+void FMeshToSetMesh::ApplyToPawn(APawn* Pawn, TConstArrayView<FMeshToSetMesh> MeshesToSetMesh)
+{
+	FStagedMeshChanges StagedMeshChanges;
+	StagedMeshChanges.Stage(MeshesToSetMesh);
+	StagedMeshChanges.Commit(Pawn);
+}
+
+void FMeshToSetMesh::MergeFrom(const FMeshToSetMesh& Other)
+{
+	if (Other.bShouldChangeMesh)
+	{
+		bShouldChangeMesh = true;
+		SkeletalMesh = Other.SkeletalMesh;
+	}
+
+	if (Other.bShouldChangeAnimInstance)
+	{
+		bShouldChangeAnimInstance = true;
+		AnimInstance = Other.AnimInstance;
+	}
+
+	if (Other.bShouldChangeLocation)
+	{
+		bShouldChangeLocation = true;
+		NewLocation = Other.NewLocation;
+	}
+
+	if (Other.bShouldChangeRotation)
+	{
+		bShouldChangeRotation = true;
+		NewRotation = Other.NewRotation;
+	}
+
+	if (Other.bShouldChangeScale)
+	{
+		bShouldChangeScale = true;
+		NewScale = Other.NewScale;
+	}
+}
+
+
+void FStagedMeshChanges::Stage(const FMeshToSetMesh& MeshToSetMesh)
+{
+	auto* StagedMesh{ StagedMeshes.FindByPredicate([&MeshToSetMesh](const FMeshToSetMesh& Item) { return Item.MeshTag == MeshToSetMesh.MeshTag; }) };
+
+	if (StagedMesh)
+	{
+		StagedMesh->MergeFrom(MeshToSetMesh);
+	}
+	else
+	{
+		StagedMeshes.Emplace(MeshToSetMesh);
+	}
+}
+
+void FStagedMeshChanges::Stage(TConstArrayView<FMeshToSetMesh> MeshesToSetMesh)
+{
+	for (const auto& MeshToSetMesh : MeshesToSetMesh)
+	{
+		Stage(MeshToSetMesh);
+	}
+}
+
+void FStagedMeshChanges::Commit(APawn* Pawn, const UCharacterInitStateComponent* InitStateComponent)
+{
+	if (Pawn)
+	{
+		for (const auto& MeshToSet : StagedMeshes)
+		{
+			auto* Mesh
+			{
+				InitStateComponent ? InitStateComponent->GetMeshByTag(MeshToSet.MeshTag) :
+				ICharacterMeshAccessorInterface::Execute_GetMeshByTag(Pawn, MeshToSet.MeshTag)
+			};
+
+			if (Mesh)
+			{
+				CommitToMesh(Mesh, MeshToSet);
+			}
+		}
+	}
+
+	StagedMeshes.Reset();
+}
+
+void FStagedMeshChanges::CommitToMesh(USkeletalMeshComponent* Mesh, const FMeshToSetMesh& MeshToSet)
+{
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Modify Mesh (Name: %s)"), *GetNameSafe(Mesh));
+
+	auto* LoadedSkeltalMesh
+	{
+		!MeshToSet.bShouldChangeMesh || MeshToSet.SkeletalMesh.IsNull() ? nullptr :
+		MeshToSet.SkeletalMesh.IsValid() ? MeshToSet.SkeletalMesh.Get() : MeshToSet.SkeletalMesh.LoadSynchronous()
+	};
+
+	auto* LoadedAnimInstanceClass
+	{
+		!MeshToSet.bShouldChangeAnimInstance || MeshToSet.AnimInstance.IsNull() ? nullptr :
+		MeshToSet.AnimInstance.IsValid() ? MeshToSet.AnimInstance.Get() : MeshToSet.AnimInstance.LoadSynchronous()
+	};
+
+	const auto bChangeMesh{ MeshToSet.bShouldChangeMesh && (Mesh->GetSkeletalMeshAsset() != LoadedSkeltalMesh) };
+
+	// Change AnimInstance
+	// If the mesh also changes, only the class is set here and the anim is initialized once by SetSkeletalMesh()
+
+	if (MeshToSet.bShouldChangeAnimInstance)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++AnimInstance (Name: %s)"), *GetNameSafe(LoadedAnimInstanceClass));
+
+		if (bChangeMesh)
+		{
+			if (LoadedAnimInstanceClass)
+			{
+				Mesh->SetAnimationMode(EAnimationMode::AnimationBlueprint, false);
+			}
+
+			Mesh->AnimClass = LoadedAnimInstanceClass;
+			Mesh->ClearAnimScriptInstance();
+		}
+		else
+		{
+			Mesh->SetAnimInstanceClass(LoadedAnimInstanceClass);
+		}
+	}
+
+	// Change Mesh
+
+	if (bChangeMesh)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SkeltalMesh (Name: %s)"), *GetNameSafe(LoadedSkeltalMesh));
+
+		Mesh->SetSkeletalMesh(LoadedSkeltalMesh);
+	}
+
+	// Change Location, Rotation and Scale with a single transform update
+
+	if (MeshToSet.bShouldChangeLocation || MeshToSet.bShouldChangeRotation || MeshToSet.bShouldChangeScale)
+	{
+		auto NewTransform{ Mesh->GetRelativeTransform() };
+
+		if (MeshToSet.bShouldChangeLocation)
+		{
+			NewTransform.SetLocation(MeshToSet.NewLocation);
+		}
+
+		if (MeshToSet.bShouldChangeRotation)
+		{
+			NewTransform.SetRotation(MeshToSet.NewRotation.Quaternion());
+		}
+
+		if (MeshToSet.bShouldChangeScale)
+		{
+			NewTransform.SetScale3D(MeshToSet.NewScale);
+		}
+
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("++SetTransform (%s)"), *NewTransform.ToString());
+
+		Mesh->SetRelativeTransform(NewTransform);
+	}
+}
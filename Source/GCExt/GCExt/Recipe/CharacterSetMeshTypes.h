@@ -7,7 +7,10 @@
 #include "CharacterSetMeshTypes.generated.h"
 
 class USkeletalMesh;
+class USkeletalMeshComponent;
 class UAnimInstance;
+class APawn;
+class UCharacterInitStateComponent;
 
 
 /**
@@ -27,13 +30,13 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (InlineEditConditionToggle))
 	bool bShouldChangeMesh{ false };
 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (EditCondition = "bShouldChangeMesh"))
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (EditCondition = "bShouldChangeMesh", AssetBundles = "Client, Server"))
 	TSoftObjectPtr<USkeletalMesh> SkeletalMesh{ nullptr };
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (InlineEditConditionToggle))
 	bool bShouldChangeAnimInstance{ false };
 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (EditCondition = "bShouldChangeAnimInstance"))
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (EditCondition = "bShouldChangeAnimInstance", AssetBundles = "Client, Server"))
 	TSoftClassPtr<UAnimInstance> AnimInstance{ nullptr };
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (InlineEditConditionToggle))
@@ -54,4 +57,68 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (EditCondition = "bShouldChangeScale"))
 	FVector NewScale{ FVector::OneVector };
 
+public:
+	/**
+	 * Apply the settings of all entries to the meshes of the pawn in a single pass per mesh
+	 * 
+	 * Tips:
+	 *	Soft references that are not loaded yet are loaded synchronously
+	 */
+	static void ApplyToPawn(APawn* Pawn, TConstArrayView<FMeshToSetMesh> MeshesToSetMesh);
+
+	/**
+	 * Overwrite the settings of this entry with the settings enabled in the other entry
+	 */
+	void MergeFrom(const FMeshToSetMesh& Other);
+
+};
+
+
+/**
+ * Mesh changes of a pawn gathered from CharacterRecipes to be committed at once
+ * 
+ * Tips:
+ *	Entries with the same MeshTag are merged, so each mesh is reconfigured only once
+ *	with a single transform update and a single anim initialization with the final mesh and class.
+ */
+USTRUCT()
+struct GCEXT_API FStagedMeshChanges
+{
+	GENERATED_BODY()
+public:
+	FStagedMeshChanges() {}
+
+protected:
+	//
+	// Merged settings of each MeshTag
+	//
+	UPROPERTY()
+	TArray<FMeshToSetMesh> StagedMeshes;
+
+public:
+	/**
+	 * Merge the settings into the staged settings of the same MeshTag
+	 */
+	void Stage(const FMeshToSetMesh& MeshToSetMesh);
+	void Stage(TConstArrayView<FMeshToSetMesh> MeshesToSetMesh);
+
+	/**
+	 * Apply the staged settings to the meshes of the pawn and clear them
+	 * 
+	 * Tips:
+	 *	If InitStateComponent is specified, meshes are found through its cache instead of querying the pawn each time.
+	 */
+	void Commit(APawn* Pawn, const UCharacterInitStateComponent* InitStateComponent = nullptr);
+
+	void Reset() { StagedMeshes.Reset(); }
+	bool IsEmpty() const { return StagedMeshes.IsEmpty(); }
+
+	const TArray<FMeshToSetMesh>& GetStagedMeshes() const { return StagedMeshes; }
+
+protected:
+	/**
+	 * Apply the settings to the mesh
+	 */
+	static void CommitToMesh(USkeletalMeshComponent* Mesh, const FMeshToSetMesh& MeshToSet);
+
 };
@@ -0,0 +1,113 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GCExtStats.h"
+
+#include "Recipe/ActiveCharacterRecipeHandle.h"
+
+#include "GameFramework/Pawn.h"
+#include "UObject/ObjectKey.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+DEFINE_STAT(STAT_GCExt_CommitPendingRecipes);
+DEFINE_STAT(STAT_GCExt_ExecuteRecipeSetup);
+DEFINE_STAT(STAT_GCExt_StartSetup);
+DEFINE_STAT(STAT_GCExt_FinishSetup);
+DEFINE_STAT(STAT_GCExt_ProcessFinishedRecipes);
+DEFINE_STAT(STAT_GCExt_CommitStagedMeshChanges);
+
+UE_TRACE_CHANNEL_DEFINE(GCExtChannel);
+
+
+namespace GCExtStats
+{
+#if STATS
+	TStatId GetRecipeStatId(const UClass* RecipeClass)
+	{
+		check(IsInGameThread());
+
+		// Keyed by object key since the address of a class destroyed by a Blueprint recompile can be reused by another class
+
+		static TMap<FObjectKey, TStatId> RecipeStatIds;
+
+		const FObjectKey ClassKey{ RecipeClass };
+
+		if (const auto* StatId{ RecipeStatIds.Find(ClassKey) })
+		{
+			return *StatId;
+		}
+
+		const auto StatId{ FDynamicStats::CreateStatId<FStatGroup_STATGROUP_GCExt>(GetNameSafe(RecipeClass)) };
+
+		RecipeStatIds.Add(ClassKey, StatId);
+
+		return StatId;
+	}
+#endif
+
+	bool IsTraceEnabled()
+	{
+		return UE_TRACE_CHANNELEXPR_IS_ENABLED(GCExtChannel);
+	}
+
+	const FString& GetRecipeTraceName(const UClass* RecipeClass)
+	{
+		check(IsInGameThread());
+
+		// Keyed by object key for the same reason as the stats
+
+		static TMap<FObjectKey, FString> RecipeTraceNames;
+
+		const FObjectKey ClassKey{ RecipeClass };
+
+		if (const auto* TraceName{ RecipeTraceNames.Find(ClassKey) })
+		{
+			return *TraceName;
+		}
+
+		return RecipeTraceNames.Add(ClassKey, GetNameSafe(RecipeClass));
+	}
+
+	FString BeginPawnRegion(const APawn* Pawn)
+	{
+		if (!IsTraceEnabled())
+		{
+			return FString();
+		}
+
+		TStringBuilder<128> RegionName;
+		RegionName << TEXT("GCExt ") << GetNameSafe(Pawn);
+
+		FString Result{ RegionName.ToString() };
+
+		TRACE_BEGIN_REGION(*Result);
+
+		return Result;
+	}
+
+	FString BeginRecipeRegion(const APawn* Pawn, const UClass* RecipeClass, const FActiveCharacterRecipeHandle& Handle)
+	{
+		if (!IsTraceEnabled())
+		{
+			return FString();
+		}
+
+		TStringBuilder<256> RegionName;
+		RegionName << TEXT("GCExt ") << GetNameSafe(Pawn) << TEXT(' ') << GetRecipeTraceName(RecipeClass) << TEXT(" [") << Handle.ToString() << TEXT(']');
+
+		FString Result{ RegionName.ToString() };
+
+		TRACE_BEGIN_REGION(*Result);
+
+		return Result;
+	}
+
+	void EndRegion(FString& RegionName)
+	{
+		if (!RegionName.IsEmpty())
+		{
+			TRACE_END_REGION(*RegionName);
+
+			RegionName.Reset();
+		}
+	}
+}
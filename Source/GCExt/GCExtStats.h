@@ -0,0 +1,137 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "UObject/UObjectBaseUtility.h"
+
+class APawn;
+class UClass;
+struct FActiveCharacterRecipeHandle;
+
+
+DECLARE_STATS_GROUP(TEXT("GCExt"), STATGROUP_GCExt, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Commit Pending Recipes"), STAT_GCExt_CommitPendingRecipes, STATGROUP_GCExt, GCEXT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Execute Recipe Setup"), STAT_GCExt_ExecuteRecipeSetup, STATGROUP_GCExt, GCEXT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Start Setup"), STAT_GCExt_StartSetup, STATGROUP_GCExt, GCEXT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Finish Setup"), STAT_GCExt_FinishSetup, STATGROUP_GCExt, GCEXT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Finished Recipes"), STAT_GCExt_ProcessFinishedRecipes, STATGROUP_GCExt, GCEXT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Commit Staged Mesh Changes"), STAT_GCExt_CommitStagedMeshChanges, STATGROUP_GCExt, GCEXT_API);
+
+/**
+ * Trace channel for CharacterRecipe events
+ *
+ * Tips:
+ *	Enable with -trace=default,region,GCExt to show the recipe class scopes and the timing regions of each pawn in Insights.
+ *
+ * Note:
+ *	Timing regions are written to the engine region channel, so they are shown only if that channel is enabled as well.
+ *	This channel only decides whether the regions are emitted, so that their names are not built otherwise.
+ */
+UE_TRACE_CHANNEL_EXTERN(GCExtChannel, GCEXT_API);
+
+
+namespace GCExtStats
+{
+#if STATS
+	/**
+	 * Returns cycle stat of the CharacterRecipe class in STATGROUP_GCExt
+	 *
+	 * Tips:
+	 *	Stats are created on first use and must be requested from the game thread.
+	 *	Stats are looked up by object key, so a class reinstanced by a Blueprint recompile gets its own stat
+	 *	instead of the one of a destroyed class that had the same address.
+	 */
+	GCEXT_API TStatId GetRecipeStatId(const UClass* RecipeClass);
+#endif
+
+	/**
+	 * Returns whether GCExtChannel is enabled
+	 */
+	GCEXT_API bool IsTraceEnabled();
+
+	/**
+	 * Returns the name of the CharacterRecipe class used in traces
+	 *
+	 * Tips:
+	 *	Names are cached by object key, so each class name is built once instead of on every trace.
+	 *	Must be called from the game thread.
+	 */
+	GCEXT_API const FString& GetRecipeTraceName(const UClass* RecipeClass);
+
+	/**
+	 * Begin the timing region covering the CharacterRecipe application of the pawn
+	 *
+	 * Tips:
+	 *	Returns the name of the region to be passed to EndRegion(), or an empty name if GCExtChannel is disabled.
+	 */
+	GCEXT_API FString BeginPawnRegion(const APawn* Pawn);
+
+	/**
+	 * Begin the timing region covering the setup of the CharacterRecipe entry on the pawn
+	 *
+	 * Tips:
+	 *	The region name includes the handle of the entry so that entries of the same class on one pawn do not collide.
+	 */
+	GCEXT_API FString BeginRecipeRegion(const APawn* Pawn, const UClass* RecipeClass, const FActiveCharacterRecipeHandle& Handle);
+
+	/**
+	 * End the timing region begun with the name and empty the name
+	 *
+	 * Tips:
+	 *	Does nothing if the name is empty, since the region has not begun.
+	 */
+	GCEXT_API void EndRegion(FString& RegionName);
+
+	/**
+	 * Traces the scope with the name of the CharacterRecipe class on GCExtChannel
+	 *
+	 * Tips:
+	 *	The name is only looked up while GCExtChannel is enabled, so the scope costs a channel check otherwise.
+	 */
+	struct FScopedRecipeTrace
+	{
+	public:
+		explicit FScopedRecipeTrace(const UClass* RecipeClass)
+		{
+#if CPUPROFILERTRACE_ENABLED
+			if (UE_TRACE_CHANNELEXPR_IS_ENABLED(GCExtChannel))
+			{
+				FCpuProfilerTrace::OutputBeginDynamicEvent(*GetRecipeTraceName(RecipeClass));
+
+				bTraced = true;
+			}
+#endif
+		}
+
+		~FScopedRecipeTrace()
+		{
+#if CPUPROFILERTRACE_ENABLED
+			if (bTraced)
+			{
+				FCpuProfilerTrace::OutputEndEvent();
+			}
+#endif
+		}
+
+	private:
+		bool bTraced{ false };
+	};
+}
+
+
+/**
+ * Counts the scope in the cycle stat of the CharacterRecipe class and traces it with the class name on GCExtChannel
+ */
+#if STATS
+#define GCEXT_RECIPE_CYCLE_COUNTER(RecipeClass) FScopeCycleCounter ANONYMOUS_VARIABLE(GCExtRecipeCycleCounter)(GCExtStats::GetRecipeStatId(RecipeClass));
+#else
+#define GCEXT_RECIPE_CYCLE_COUNTER(RecipeClass)
+#endif
+
+#define GCEXT_SCOPE_RECIPE(RecipeClass) \
+	GCEXT_RECIPE_CYCLE_COUNTER(RecipeClass) \
+	GCExtStats::FScopedRecipeTrace ANONYMOUS_VARIABLE(GCExtRecipeTrace)(RecipeClass);
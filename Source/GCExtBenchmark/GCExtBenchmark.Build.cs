@@ -0,0 +1,38 @@
+﻿// Copyright (C) 2024 owoDra
+
+using UnrealBuildTool;
+
+public class GCExtBenchmark : ModuleRules
+{
+	public GCExtBenchmark(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicIncludePaths.AddRange(
+            new string[]
+            {
+                ModuleDirectory,
+                ModuleDirectory + "/GCExtBenchmark",
+            }
+        );
+
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "GCExt",
+            }
+        );
+
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "AIModule",
+            }
+        );
+    }
+}
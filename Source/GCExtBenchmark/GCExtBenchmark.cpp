@@ -0,0 +1,5 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GCExtBenchmark.h"
+
+IMPLEMENT_MODULE(FGCExtBenchmarkModule, GCExtBenchmark)
@@ -0,0 +1,19 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Modules/ModuleManager.h"
+
+/**
+ *  Modules for the benchmark of the Game Character Extension plugin
+ *
+ *  Tips:
+ *	Loaded as a developer tool, so the synthetic CharacterRecipes and the benchmark command are not included in shipping builds.
+ */
+class FGCExtBenchmarkModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override {}
+	virtual void ShutdownModule() override {}
+
+};
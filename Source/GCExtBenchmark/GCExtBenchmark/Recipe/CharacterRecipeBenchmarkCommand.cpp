@@ -0,0 +1,735 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "Recipe/CharacterRecipe_Benchmark.h"
+
+#include "CharacterInitStateComponent.h"
+#include "GCExtLogs.h"
+
+#include "AIController.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Pawn.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Parse.h"
+#include "Misc/DateTime.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/SoftObjectPath.h"
+
+
+/**
+ * Allocator that forwards to the original GMalloc and counts the allocations of the game thread while counting is enabled
+ *
+ * Tips:
+ *	Installed only while the benchmark is running. The instance is never destroyed,
+ *	so a thread that read GMalloc just before it is restored can still use it safely.
+ */
+class FCharacterRecipeBenchmarkMalloc final : public FMalloc
+{
+public:
+	static FCharacterRecipeBenchmarkMalloc& Get()
+	{
+		static auto* Instance{ new FCharacterRecipeBenchmarkMalloc() };
+
+		return *Instance;
+	}
+
+protected:
+	FMalloc* InnerMalloc{ nullptr };
+
+	bool bCounting{ false };
+	int32 NumAllocations{ 0 };
+
+public:
+	void Install()
+	{
+		check(IsInGameThread());
+
+		if (!InnerMalloc)
+		{
+			InnerMalloc = GMalloc;
+			GMalloc = this;
+		}
+	}
+
+	void Uninstall()
+	{
+		check(IsInGameThread());
+
+		if (InnerMalloc)
+		{
+			GMalloc = InnerMalloc;
+			InnerMalloc = nullptr;
+		}
+	}
+
+	/**
+	 * Start counting the allocations of the game thread
+	 */
+	void BeginCount()
+	{
+		NumAllocations = 0;
+		bCounting = (InnerMalloc != nullptr);
+	}
+
+	/**
+	 * Stop counting and returns the number of allocations since BeginCount()
+	 */
+	int32 EndCount()
+	{
+		bCounting = false;
+
+		return NumAllocations;
+	}
+
+public:
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { InnerMalloc->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+protected:
+	void CountAllocation()
+	{
+		if (bCounting && IsInGameThread())
+		{
+			++NumAllocations;
+		}
+	}
+
+};
+
+
+/**
+ * Runs the spawn-scaling benchmark of CharacterRecipes in a game world
+ *
+ * Tips:
+ *	For each pawn count, pawns with CharacterInitStateComponent are spawned and the synthetic CharacterRecipes are committed.
+ *	The run ends when all pawns reach Complete, and the results of all runs are written to CSV in Saved/Profiling/GCExt.
+ *
+ *	Run headless with:
+ *	-game -nullrhi -ExecCmds="gcext.Recipe.Benchmark 1+10+100+500+1000+2000 1 exit"
+ *	Lists are separated with "+", since -ExecCmds splits the commands at commas. "," is also accepted when typed in the console.
+ *
+ *	To measure replication, run it on a listen server with clients connected (e.g. PIE with Play As Listen Server and 2 players).
+ *	The pawns are then always relevant, each run waits NetSettleSeconds after Complete, and the bytes sent by the server during the run are recorded.
+ *	Replication CPU time is included in FrameGameThreadMs of the listen server. In standalone, the network columns are 0.
+ *
+ *	To measure project content, pass a pawn class with "pawn=" and the CharacterRecipe classes to commit with "recipes=" instead of the synthetic ones (RecipesPerPolicy is then ignored).
+ *	With "settle=", the pawns are kept for the seconds after Complete, and SettleFrameGameThreadMs is the average game thread time
+ *	of a frame during that time, i.e. the steady-state cost of the pawns such as their animation.
+ *	For example, compare the game thread time of 500 crowd NPCs with and without CharacterRecipe_AnimationSharing:
+ *	-game -nullrhi -ExecCmds="gcext.Recipe.Benchmark 500 1 pawn=/Game/NPC/BP_NPC.BP_NPC_C recipes=/Game/NPC/CR_Anim.CR_Anim_C settle=10 exit"
+ *	-game -nullrhi -ExecCmds="gcext.Recipe.Benchmark 500 1 pawn=/Game/NPC/BP_NPC.BP_NPC_C recipes=/Game/NPC/CR_Anim.CR_Anim_C+/Game/NPC/CR_AnimSharing.CR_AnimSharing_C settle=10 exit"
+ *	Set VisibilityBasedAnimTickOption of the meshes to AlwaysTickPoseAndRefreshBones, since nothing is rendered with -nullrhi.
+ *	Disable bAutoCommitCharacterRecipes of the pawn so that its DefaultCharacterRecipes are committed with the benchmark recipes.
+ *
+ * Note:
+ *	Each pawn is possessed by an AIController so that LocalOnly recipes run on the server or in standalone.
+ *	The spawn of the controller is included in the measured time and objects.
+ *
+ *	Net execution policies only differ over a connection. In standalone every policy runs locally,
+ *	so ServerOnly and ClientOnly recipes are measured as the same work. Use the listen server setup to exercise them.
+ *	On the clients, the pawns are simulated proxies, so ServerOnly and LocalOnly recipes do not run there.
+ *
+ *	UObjectsCreated counts every UObject created during the run, including the ones collected before it ends.
+ *	LiveUObjectDelta is the change in the number of live UObjects between the start and the end of the run.
+ *	PeakUsedPhysicalDeltaMB is the highest used physical memory sampled each frame during the run, relative to the start.
+ *
+ *	AddPendingHeapAllocsPerPawn and CommitHeapAllocsPerPawn are the average heap allocations of the game thread
+ *	while adding the pending CharacterRecipes of a pawn and while committing them.
+ *	PendingRecipes keeps up to FActiveCharacterRecipeContainer::NumInlinePendingRecipes entries without allocating,
+ *	so compare RecipesPerPolicy 2 (16 recipes) and 3 (24 recipes) to see the cost of leaving the inline storage.
+ */
+class FCharacterRecipeBenchmark : public FUObjectArray::FUObjectCreateListener
+{
+public:
+	struct FSettings
+	{
+		TArray<int32> PawnCounts{ 1, 10, 100, 500, 1000, 2000 };
+		int32 RecipesPerPolicy{ 1 };
+		bool bExitWhenDone{ false };
+		UClass* PawnClass{ nullptr };
+		TArray<UClass*> RecipeClasses;
+		double SettleSeconds{ 0.0 };
+	};
+
+	FCharacterRecipeBenchmark(UWorld* InWorld, FSettings&& InSettings)
+		: World(InWorld)
+		, PawnCounts(MoveTemp(InSettings.PawnCounts))
+		, RecipesPerPolicy(InSettings.RecipesPerPolicy)
+		, bExitWhenDone(InSettings.bExitWhenDone)
+		, PawnClass(InSettings.PawnClass ? InSettings.PawnClass : APawn::StaticClass())
+		, SettleSeconds(InSettings.SettleSeconds)
+	{
+		for (auto* RecipeClass : InSettings.RecipeClasses)
+		{
+			CustomRecipeClasses.Emplace(RecipeClass);
+		}
+	}
+
+	virtual ~FCharacterRecipeBenchmark()
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+		GUObjectArray.RemoveUObjectCreateListener(this);
+
+		FCharacterRecipeBenchmarkMalloc::Get().Uninstall();
+
+		DestroyPawns();
+
+		LogGameExt_CharacterRecipe.SetVerbosity(SavedLogVerbosity);
+	}
+
+public:
+	static TUniquePtr<FCharacterRecipeBenchmark> ActiveBenchmark;
+
+protected:
+	struct FPawnRecord
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		double CommitTime{ 0.0 };
+		double CompleteTime{ 0.0 };
+	};
+
+	TWeakObjectPtr<UWorld> World;
+	TArray<int32> PawnCounts;
+	int32 RecipesPerPolicy{ 1 };
+	bool bExitWhenDone{ false };
+	TStrongObjectPtr<UClass> PawnClass;
+	TArray<TStrongObjectPtr<UClass>> CustomRecipeClasses;
+	double SettleSeconds{ 0.0 };
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	ELogVerbosity::Type SavedLogVerbosity{ ELogVerbosity::Log };
+
+	int32 RunIndex{ INDEX_NONE };
+	TArray<FPawnRecord> PawnRecords;
+	int32 NumCompleted{ 0 };
+	double RunStartTime{ 0.0 };
+	double SetupGameThreadMs{ 0.0 };
+	int64 NumAddPendingHeapAllocs{ 0 };
+	int64 NumCommitHeapAllocs{ 0 };
+	double FrameGameThreadMs{ 0.0 };
+	int32 NumFrames{ 0 };
+	int32 NumObjectsBefore{ 0 };
+	int32 NumObjectsCreated{ 0 };
+	uint64 UsedPhysicalBefore{ 0 };
+	uint64 PeakUsedPhysical{ 0 };
+	uint64 NetOutBytesBefore{ 0 };
+	uint64 NetOutPacketsBefore{ 0 };
+	double AllCompletedTime{ 0.0 };
+	double SettleFrameGameThreadMs{ 0.0 };
+	int32 NumSettleFrames{ 0 };
+	int32 NumRecipesPerPawn{ 0 };
+
+	FString Csv;
+
+	static constexpr double RunTimeoutSeconds{ 60.0 };
+	static constexpr double NetSettleSeconds{ 2.0 };
+	static constexpr int32 NumPolicyClasses{ 8 };
+
+public:
+	void Start()
+	{
+		SavedLogVerbosity = LogGameExt_CharacterRecipe.GetVerbosity();
+
+		if (!GetServerNetDriverWithClients())
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterRecipe benchmark is running without client connections, net execution policies are not exercised"));
+		}
+
+		Csv = TEXT("Pawns,RecipesPerPawn,LatencyP50Ms,LatencyP90Ms,LatencyP99Ms,LatencyMaxMs,Completed,SetupGameThreadMs,FrameGameThreadMs,Frames,SettleFrameGameThreadMs,AddPendingHeapAllocsPerPawn,CommitHeapAllocsPerPawn,UObjectsCreated,LiveUObjectDelta,UsedPhysicalDeltaMB,PeakUsedPhysicalDeltaMB,ClientConnections,NetOutKB,NetOutPackets\n");
+
+		GUObjectArray.AddUObjectCreateListener(this);
+
+		FCharacterRecipeBenchmarkMalloc::Get().Install();
+
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FCharacterRecipeBenchmark::Tick));
+
+		StartNextRun();
+	}
+
+	virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override
+	{
+		FPlatformAtomics::InterlockedIncrement(&NumObjectsCreated);
+	}
+
+	virtual void OnUObjectArrayShutdown() override
+	{
+		GUObjectArray.RemoveUObjectCreateListener(this);
+	}
+
+protected:
+	/**
+	 * Returns the net driver of the server if any client is connected
+	 */
+	UNetDriver* GetServerNetDriverWithClients() const
+	{
+		const auto* CurrentWorld{ World.Get() };
+		auto* NetDriver{ CurrentWorld ? CurrentWorld->GetNetDriver() : nullptr };
+
+		return (NetDriver && NetDriver->IsServer() && !NetDriver->ClientConnections.IsEmpty()) ? NetDriver : nullptr;
+	}
+
+	TArray<TSubclassOf<UCharacterRecipe>> GetRecipeClasses() const
+	{
+		if (!CustomRecipeClasses.IsEmpty())
+		{
+			TArray<TSubclassOf<UCharacterRecipe>> Classes;
+			Classes.Reserve(CustomRecipeClasses.Num());
+
+			for (const auto& RecipeClass : CustomRecipeClasses)
+			{
+				Classes.Emplace(RecipeClass.Get());
+			}
+
+			return Classes;
+		}
+
+		const TSubclassOf<UCharacterRecipe> PolicyClasses[]
+		{
+			UCharacterRecipe_Benchmark_InstancedBoth::StaticClass(),
+			UCharacterRecipe_Benchmark_InstancedServerOnly::StaticClass(),
+			UCharacterRecipe_Benchmark_InstancedClientOnly::StaticClass(),
+			UCharacterRecipe_Benchmark_InstancedLocalOnly::StaticClass(),
+			UCharacterRecipe_Benchmark_NonInstancedBoth::StaticClass(),
+			UCharacterRecipe_Benchmark_NonInstancedServerOnly::StaticClass(),
+			UCharacterRecipe_Benchmark_NonInstancedClientOnly::StaticClass(),
+			UCharacterRecipe_Benchmark_NonInstancedLocalOnly::StaticClass(),
+		};
+
+		static_assert(UE_ARRAY_COUNT(PolicyClasses) == NumPolicyClasses);
+
+		TArray<TSubclassOf<UCharacterRecipe>> Classes;
+		Classes.Reserve(UE_ARRAY_COUNT(PolicyClasses) * RecipesPerPolicy);
+
+		for (auto Index{ 0 }; Index < RecipesPerPolicy; ++Index)
+		{
+			Classes.Append(PolicyClasses, UE_ARRAY_COUNT(PolicyClasses));
+		}
+
+		return Classes;
+	}
+
+	void StartNextRun()
+	{
+		DestroyPawns();
+
+		++RunIndex;
+
+		auto* CurrentWorld{ World.Get() };
+
+		if (!CurrentWorld || !PawnCounts.IsValidIndex(RunIndex))
+		{
+			Finish();
+			return;
+		}
+
+		const auto NumPawns{ PawnCounts[RunIndex] };
+		const auto RecipeClasses{ GetRecipeClasses() };
+
+		// Per-recipe logs would dominate the measured time
+
+		LogGameExt_CharacterRecipe.SetVerbosity(ELogVerbosity::Fatal);
+
+		NumCompleted = 0;
+		NumFrames = 0;
+		NumAddPendingHeapAllocs = 0;
+		NumCommitHeapAllocs = 0;
+		FrameGameThreadMs = 0.0;
+		NumObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+		NumObjectsCreated = 0;
+		UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+		PeakUsedPhysical = UsedPhysicalBefore;
+		AllCompletedTime = 0.0;
+		SettleFrameGameThreadMs = 0.0;
+		NumSettleFrames = 0;
+		NumRecipesPerPawn = RecipeClasses.Num();
+
+		auto* NetDriver{ GetServerNetDriverWithClients() };
+		NetOutBytesBefore = NetDriver ? static_cast<uint64>(NetDriver->OutTotalBytes) : 0;
+		NetOutPacketsBefore = NetDriver ? static_cast<uint64>(NetDriver->OutTotalPackets) : 0;
+
+		// Records are only added for spawned pawns, so that a failed spawn does not keep the run waiting until the timeout
+
+		PawnRecords.Reset(NumPawns);
+
+		RunStartTime = FPlatformTime::Seconds();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.ObjectFlags |= RF_Transient;
+
+		for (auto Index{ 0 }; Index < NumPawns; ++Index)
+		{
+			auto* Pawn{ CurrentWorld->SpawnActor<APawn>(PawnClass.Get(), FTransform::Identity, SpawnParams) };
+
+			if (!Pawn)
+			{
+				continue;
+			}
+
+			// Replicate every pawn to every client regardless of distance
+
+			if (NetDriver)
+			{
+				Pawn->bAlwaysRelevant = true;
+			}
+
+			// Possess the pawn so that LocalOnly recipes are executed
+
+			if (!Pawn->GetController())
+			{
+				if (!Pawn->AIControllerClass)
+				{
+					Pawn->AIControllerClass = AAIController::StaticClass();
+				}
+
+				Pawn->SpawnDefaultController();
+			}
+
+			auto* InitStateComponent{ Pawn->FindComponentByClass<UCharacterInitStateComponent>() };
+
+			if (!InitStateComponent)
+			{
+				InitStateComponent = NewObject<UCharacterInitStateComponent>(Pawn, NAME_None, RF_Transient);
+				InitStateComponent->RegisterComponent();
+			}
+
+			const auto RecordIndex{ PawnRecords.AddDefaulted() };
+
+			InitStateComponent->OnAllCharacterRecipesFinished.AddRaw(this, &FCharacterRecipeBenchmark::HandlePawnCompleted, RecordIndex);
+
+			// Added one by one so that the returned handle array is not counted as an allocation of PendingRecipes
+
+			auto& CountingMalloc{ FCharacterRecipeBenchmarkMalloc::Get() };
+
+			CountingMalloc.BeginCount();
+
+			for (const auto& RecipeClass : RecipeClasses)
+			{
+				InitStateComponent->AddPendingCharacterRecipe(RecipeClass);
+			}
+
+			NumAddPendingHeapAllocs += CountingMalloc.EndCount();
+
+			auto& Record{ PawnRecords[RecordIndex] };
+			Record.Pawn = Pawn;
+			Record.CommitTime = FPlatformTime::Seconds();
+
+			CountingMalloc.BeginCount();
+
+			InitStateComponent->CommitPendingCharacterRecipes();
+
+			NumCommitHeapAllocs += CountingMalloc.EndCount();
+		}
+
+		SetupGameThreadMs = (FPlatformTime::Seconds() - RunStartTime) * 1000.0;
+
+		SamplePeakMemory();
+	}
+
+	void SamplePeakMemory()
+	{
+		PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	void HandlePawnCompleted(int32 Index)
+	{
+		if (PawnRecords.IsValidIndex(Index) && (PawnRecords[Index].CompleteTime == 0.0))
+		{
+			PawnRecords[Index].CompleteTime = FPlatformTime::Seconds();
+
+			++NumCompleted;
+		}
+	}
+
+	bool Tick(float DeltaTime)
+	{
+		// GGameThreadTime holds the game thread time of the previous frame
+
+		++NumFrames;
+		FrameGameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+
+		SamplePeakMemory();
+
+		const auto Now{ FPlatformTime::Seconds() };
+		const auto bTimedOut{ (Now - RunStartTime) > RunTimeoutSeconds };
+
+		// Keep running for a while after Complete so that the replication to the clients and the steady-state cost are included in the run
+
+		auto bAllCompleted{ NumCompleted >= PawnRecords.Num() };
+
+		const auto RunSettleSeconds{ FMath::Max(SettleSeconds, GetServerNetDriverWithClients() ? NetSettleSeconds : 0.0) };
+
+		if (bAllCompleted && (RunSettleSeconds > 0.0))
+		{
+			if (AllCompletedTime == 0.0)
+			{
+				AllCompletedTime = Now;
+			}
+			else
+			{
+				++NumSettleFrames;
+				SettleFrameGameThreadMs += FPlatformTime::ToMilliseconds(GGameThreadTime);
+			}
+
+			bAllCompleted = (Now - AllCompletedTime) >= RunSettleSeconds;
+		}
+
+		if (bAllCompleted || bTimedOut)
+		{
+			RecordRun();
+
+			if (bTimedOut)
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("CharacterRecipe benchmark run timed out (%d / %d pawns completed)"), NumCompleted, PawnRecords.Num());
+			}
+
+			StartNextRun();
+		}
+
+		return true;
+	}
+
+	void RecordRun()
+	{
+		LogGameExt_CharacterRecipe.SetVerbosity(SavedLogVerbosity);
+
+		TArray<double> Latencies;
+		Latencies.Reserve(PawnRecords.Num());
+
+		for (const auto& Record : PawnRecords)
+		{
+			if (Record.CompleteTime > 0.0)
+			{
+				Latencies.Add((Record.CompleteTime - Record.CommitTime) * 1000.0);
+			}
+		}
+
+		Latencies.Sort();
+
+		const auto Percentile
+		{
+			[&Latencies](double Fraction)
+			{
+				return Latencies.IsEmpty() ? 0.0 : Latencies[FMath::Clamp(FMath::CeilToInt32(Fraction * Latencies.Num()) - 1, 0, Latencies.Num() - 1)];
+			}
+		};
+
+		SamplePeakMemory();
+
+		const auto MemoryStats{ FPlatformMemory::GetStats() };
+		const auto UsedPhysicalDeltaMB{ (static_cast<double>(MemoryStats.UsedPhysical) - static_cast<double>(UsedPhysicalBefore)) / (1024.0 * 1024.0) };
+		const auto PeakUsedPhysicalDeltaMB{ (static_cast<double>(PeakUsedPhysical) - static_cast<double>(UsedPhysicalBefore)) / (1024.0 * 1024.0) };
+		const auto LiveUObjectDelta{ GUObjectArray.GetObjectArrayNumMinusAvailable() - NumObjectsBefore };
+
+		const auto* NetDriver{ GetServerNetDriverWithClients() };
+		const auto NumClientConnections{ NetDriver ? NetDriver->ClientConnections.Num() : 0 };
+		const auto NetOutKB{ NetDriver ? static_cast<double>(static_cast<uint64>(NetDriver->OutTotalBytes) - NetOutBytesBefore) / 1024.0 : 0.0 };
+		const auto NetOutPackets{ NetDriver ? static_cast<uint64>(NetDriver->OutTotalPackets) - NetOutPacketsBefore : 0 };
+
+		const auto NumPawns{ FMath::Max(PawnRecords.Num(), 1) };
+		const auto AddPendingHeapAllocsPerPawn{ static_cast<double>(NumAddPendingHeapAllocs) / NumPawns };
+		const auto CommitHeapAllocsPerPawn{ static_cast<double>(NumCommitHeapAllocs) / NumPawns };
+
+		const auto AverageSettleFrameGameThreadMs{ (NumSettleFrames > 0) ? SettleFrameGameThreadMs / NumSettleFrames : 0.0 };
+
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.3f,%.3f,%d,%.3f,%.3f,%d,%.3f,%.2f,%.2f,%d,%d,%.2f,%.2f,%d,%.2f,%llu\n")
+			, PawnRecords.Num(), NumRecipesPerPawn
+			, Percentile(0.5), Percentile(0.9), Percentile(0.99), Percentile(1.0)
+			, NumCompleted, SetupGameThreadMs, FrameGameThreadMs, NumFrames, AverageSettleFrameGameThreadMs
+			, AddPendingHeapAllocsPerPawn, CommitHeapAllocsPerPawn
+			, NumObjectsCreated, LiveUObjectDelta, UsedPhysicalDeltaMB, PeakUsedPhysicalDeltaMB
+			, NumClientConnections, NetOutKB, NetOutPackets);
+
+		UE_LOG(LogGameExt_CharacterRecipe, Display, TEXT("CharacterRecipe benchmark: %d pawns, P50 %.3f ms, P99 %.3f ms, Setup %.3f ms")
+			, PawnRecords.Num(), Percentile(0.5), Percentile(0.99), SetupGameThreadMs);
+	}
+
+	void DestroyPawns()
+	{
+		for (const auto& Record : PawnRecords)
+		{
+			if (auto* Pawn{ Record.Pawn.Get() })
+			{
+				if (auto* InitStateComponent{ Pawn->FindComponentByClass<UCharacterInitStateComponent>() })
+				{
+					InitStateComponent->OnAllCharacterRecipesFinished.RemoveAll(this);
+				}
+
+				if (auto* Controller{ Pawn->GetController() })
+				{
+					Controller->Destroy();
+				}
+
+				Pawn->Destroy();
+			}
+		}
+
+		PawnRecords.Reset();
+	}
+
+	void Finish()
+	{
+		const auto FilePath
+		{
+			FPaths::Combine(FPaths::ProfilingDir(), TEXT("GCExt"), FString::Printf(TEXT("RecipeBenchmark-%s.csv"), *FDateTime::Now().ToString()))
+		};
+
+		if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Display, TEXT("CharacterRecipe benchmark results written to %s"), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Failed to write CharacterRecipe benchmark results to %s"), *FilePath);
+		}
+
+		if (bExitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+
+		// Destroys this instance, so nothing may follow
+
+		ActiveBenchmark.Reset();
+	}
+
+};
+
+TUniquePtr<FCharacterRecipeBenchmark> FCharacterRecipeBenchmark::ActiveBenchmark;
+
+
+/**
+ * Split the list argument of the benchmark command at "+" or ","
+ */
+static void ParseListArg(const FString& Arg, TArray<FString>& OutValues)
+{
+	static const TCHAR* Delimiters[]{ TEXT("+"), TEXT(",") };
+
+	Arg.ParseIntoArray(OutValues, Delimiters, UE_ARRAY_COUNT(Delimiters));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdCharacterRecipeBenchmark(
+	TEXT("gcext.Recipe.Benchmark"),
+	TEXT("Spawn pawns with synthetic CharacterRecipes of each policy and write commit-to-Complete latency, game thread time, UObject and memory usage to CSV.\n")
+	TEXT("Net execution policies are only exercised on a listen server with clients connected, where the bytes sent to the clients are also recorded.\n")
+	TEXT("Usage: gcext.Recipe.Benchmark [PawnCounts=1+10+100+500+1000+2000] [RecipesPerPolicy=1] [pawn=PawnClassPath] [recipes=RecipeClassPath+...] [settle=Seconds] [exit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World || !World->IsGameWorld())
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("gcext.Recipe.Benchmark must be run in a game world"));
+				return;
+			}
+
+			if (FCharacterRecipeBenchmark::ActiveBenchmark.IsValid())
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("gcext.Recipe.Benchmark is already running"));
+				return;
+			}
+
+			FCharacterRecipeBenchmark::FSettings Settings;
+
+			// Positional arguments are the pawn counts and the recipes per policy, others are named
+
+			TArray<FString> PositionalArgs;
+
+			for (const auto& Arg : Args)
+			{
+				FString Value;
+
+				if (Arg == TEXT("exit"))
+				{
+					Settings.bExitWhenDone = true;
+				}
+				else if (FParse::Value(*Arg, TEXT("pawn="), Value))
+				{
+					Settings.PawnClass = FSoftClassPath(Value).TryLoadClass<APawn>();
+
+					if (!Settings.PawnClass)
+					{
+						UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("gcext.Recipe.Benchmark failed to load pawn class %s"), *Value);
+						return;
+					}
+				}
+				else if (FParse::Value(*Arg, TEXT("recipes="), Value, false))
+				{
+					TArray<FString> ClassPaths;
+					ParseListArg(Value, ClassPaths);
+
+					for (const auto& ClassPath : ClassPaths)
+					{
+						auto* RecipeClass{ FSoftClassPath(ClassPath).TryLoadClass<UCharacterRecipe>() };
+
+						if (!RecipeClass)
+						{
+							UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("gcext.Recipe.Benchmark failed to load CharacterRecipe class %s"), *ClassPath);
+							return;
+						}
+
+						Settings.RecipeClasses.Add(RecipeClass);
+					}
+				}
+				else if (FParse::Value(*Arg, TEXT("settle="), Value))
+				{
+					Settings.SettleSeconds = FMath::Max(FCString::Atod(*Value), 0.0);
+				}
+				else
+				{
+					PositionalArgs.Add(Arg);
+				}
+			}
+
+			if (PositionalArgs.IsValidIndex(0))
+			{
+				TArray<FString> CountStrings;
+				ParseListArg(PositionalArgs[0], CountStrings);
+
+				Settings.PawnCounts.Reset();
+
+				for (const auto& CountString : CountStrings)
+				{
+					Settings.PawnCounts.Add(FMath::Max(FCString::Atoi(*CountString), 1));
+				}
+			}
+
+			if (PositionalArgs.IsValidIndex(1))
+			{
+				Settings.RecipesPerPolicy = FMath::Max(FCString::Atoi(*PositionalArgs[1]), 1);
+			}
+
+			FCharacterRecipeBenchmark::ActiveBenchmark = MakeUnique<FCharacterRecipeBenchmark>(World, MoveTemp(Settings));
+			FCharacterRecipeBenchmark::ActiveBenchmark->Start();
+		}));
@@ -0,0 +1,60 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipe_Benchmark.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe_Benchmark)
+
+
+void UCharacterRecipe_Benchmark::StartSetup_Implementation(const FCharacterRecipePawnInfo& Info)
+{
+	FinishSetup();
+}
+
+
+UCharacterRecipe_Benchmark_InstancedBoth::UCharacterRecipe_Benchmark_InstancedBoth()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::Both;
+}
+
+UCharacterRecipe_Benchmark_InstancedServerOnly::UCharacterRecipe_Benchmark_InstancedServerOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ServerOnly;
+}
+
+UCharacterRecipe_Benchmark_InstancedClientOnly::UCharacterRecipe_Benchmark_InstancedClientOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ClientOnly;
+}
+
+UCharacterRecipe_Benchmark_InstancedLocalOnly::UCharacterRecipe_Benchmark_InstancedLocalOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::LocalOnly;
+}
+
+UCharacterRecipe_Benchmark_NonInstancedBoth::UCharacterRecipe_Benchmark_NonInstancedBoth()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::Both;
+}
+
+UCharacterRecipe_Benchmark_NonInstancedServerOnly::UCharacterRecipe_Benchmark_NonInstancedServerOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ServerOnly;
+}
+
+UCharacterRecipe_Benchmark_NonInstancedClientOnly::UCharacterRecipe_Benchmark_NonInstancedClientOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ClientOnly;
+}
+
+UCharacterRecipe_Benchmark_NonInstancedLocalOnly::UCharacterRecipe_Benchmark_NonInstancedLocalOnly()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::LocalOnly;
+}
@@ -0,0 +1,94 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipe.h"
+
+#include "CharacterRecipe_Benchmark.generated.h"
+
+
+/**
+ * Synthetic CharacterRecipe used by "gcext.Recipe.Benchmark"
+ *
+ * Tips:
+ *	Finishes immediately without touching the pawn so that the benchmark measures only the overhead of the recipe lifecycle.
+ *	One subclass exists for each combination of InstancingPolicy and NetExecutionPolicy.
+ *	These classes are only in builds with developer tools, so they are part of CharacterRecipeRegistry and its checksum
+ *	only in builds that can also run the benchmark.
+ */
+UCLASS(Abstract, HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark : public UCharacterRecipe
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark() {}
+
+protected:
+	virtual void StartSetup_Implementation(const FCharacterRecipePawnInfo& Info) override;
+
+};
+
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_InstancedBoth final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_InstancedBoth();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_InstancedServerOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_InstancedServerOnly();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_InstancedClientOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_InstancedClientOnly();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_InstancedLocalOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_InstancedLocalOnly();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_NonInstancedBoth final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_NonInstancedBoth();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_NonInstancedServerOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_NonInstancedServerOnly();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_NonInstancedClientOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_NonInstancedClientOnly();
+};
+
+UCLASS(HideDropdown, NotBlueprintable)
+class UCharacterRecipe_Benchmark_NonInstancedLocalOnly final : public UCharacterRecipe_Benchmark
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_Benchmark_NonInstancedLocalOnly();
+};
@@ -0,0 +1,51 @@
+﻿// Copyright (C) 2024 owoDra
+
+using UnrealBuildTool;
+
+public class GCExtCrowd : ModuleRules
+{
+	public GCExtCrowd(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicIncludePaths.AddRange(
+            new string[]
+            {
+                ModuleDirectory,
+                ModuleDirectory + "/GCExtCrowd",
+            }
+        );
+
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "GameplayTags",
+                "GCExt",
+            }
+        );
+
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "SkeletalMerging",
+                "AnimationSharing",
+            }
+        );
+
+
+        if (Target.bBuildEditor)
+        {
+            PrivateDependencyModuleNames.AddRange(
+                new string[]
+                {
+                    "DerivedDataCache",
+                }
+            );
+        }
+    }
+}
@@ -0,0 +1,5 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "GCExtCrowd.h"
+
+IMPLEMENT_MODULE(FGCExtCrowdModule, GCExtCrowd)
@@ -0,0 +1,20 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Modules/ModuleManager.h"
+
+/**
+ *  Modules for the optional crowd features of the Game Character Extension plugin
+ *
+ *  Tips:
+ *	Contains the CharacterRecipes that depend on the SkeletalMerging and AnimationSharing plugins.
+ *	Projects that do not use them can remove this module from the plugin descriptor without affecting GCExt.
+ */
+class FGCExtCrowdModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override {}
+	virtual void ShutdownModule() override {}
+
+};
@@ -0,0 +1,312 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterMergedMeshCache.h"
+
+#include "GCExtLogs.h"
+
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkinnedAssetCommon.h"
+#include "Animation/Skeleton.h"
+#include "SkeletalMeshMerge.h"
+#include "HAL/IConsoleManager.h"
+#include "Algo/Compare.h"
+
+#if WITH_EDITOR
+#include "DerivedDataCacheInterface.h"
+#include "Rendering/SkeletalMeshModel.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Misc/SecureHash.h"
+#endif
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterMergedMeshCache)
+
+
+static int32 GCharacterMergedMeshCacheMaxEntries{ 64 };
+static FAutoConsoleVariableRef CVarCharacterMergedMeshCacheMaxEntries(
+	TEXT("gcext.Recipe.MergedMeshCacheMaxEntries"),
+	GCharacterMergedMeshCacheMaxEntries,
+	TEXT("Maximum number of merged SkeletalMeshes kept in the cache per world. 0 disables the cache."),
+	ECVF_Default);
+
+#if WITH_EDITOR
+static bool GCharacterMergedMeshDerivedDataCache{ true };
+static FAutoConsoleVariableRef CVarCharacterMergedMeshDerivedDataCache(
+	TEXT("gcext.Recipe.MergedMeshDerivedDataCache"),
+	GCharacterMergedMeshDerivedDataCache,
+	TEXT("Whether merged SkeletalMeshes are stored in and loaded from the derived data cache in the editor."),
+	ECVF_Default);
+#endif
+
+
+void UCharacterMergedMeshCache::ClearCache()
+{
+	MergedMeshes.Empty();
+	MergedMeshKeys.Reset();
+}
+
+
+USkeletalMesh* UCharacterMergedMeshCache::FindOrMergeMesh(TConstArrayView<USkeletalMesh*> Parts, USkeleton* Skeleton)
+{
+	if (Parts.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	if (!Skeleton)
+	{
+		Skeleton = Parts[0]->GetSkeleton();
+	}
+
+	const auto Key{ CalculateKey(Parts, Skeleton) };
+
+	// Compare the parts as well so that a hash collision does not return a mesh of another outfit
+
+	if (const auto* Entry{ MergedMeshes.Find(Key) })
+	{
+		const auto bSameParts
+		{
+			(Entry->Parts.Num() == Parts.Num()) &&
+			Algo::CompareByPredicate(Entry->Parts, Parts, [](const TObjectPtr<USkeletalMesh>& A, const USkeletalMesh* B) { return A == B; })
+		};
+
+		if (Entry->MergedMesh && (Entry->Skeleton == Skeleton) && bSameParts)
+		{
+			RecordLookup(true);
+
+			return Entry->MergedMesh;
+		}
+	}
+
+	RecordLookup(false);
+
+	if (!CanMergeParts(Parts))
+	{
+		return nullptr;
+	}
+
+	auto* MergedMesh{ MergeMesh(Parts, Skeleton) };
+
+	if (!MergedMesh)
+	{
+		return nullptr;
+	}
+
+	// Remove the oldest merged meshes if the cache is full
+	// Meshes still used by pawns are kept alive by their components
+
+	FCharacterMergedMeshCacheEntry NewEntry;
+	NewEntry.Parts.Append(Parts.GetData(), Parts.Num());
+	NewEntry.Skeleton = Skeleton;
+	NewEntry.MergedMesh = MergedMesh;
+
+	MergedMeshKeys.Add(MergedMeshes, Key, MoveTemp(NewEntry), GCharacterMergedMeshCacheMaxEntries);
+
+	return MergedMesh;
+}
+
+
+uint32 UCharacterMergedMeshCache::CalculateKey(TConstArrayView<USkeletalMesh*> Parts, const USkeleton* Skeleton)
+{
+	auto Key{ GetTypeHash(Skeleton) };
+
+	for (const auto* Part : Parts)
+	{
+		Key = HashCombine(Key, GetTypeHash(Part));
+	}
+
+	return Key;
+}
+
+bool UCharacterMergedMeshCache::CanMergeParts(TConstArrayView<USkeletalMesh*> Parts)
+{
+	if (!FPlatformProperties::RequiresCookedData())
+	{
+		return true;
+	}
+
+	// Cooked render data is only kept on the CPU for LODs that allow CPU access
+
+	for (const auto* Part : Parts)
+	{
+		for (auto LODIndex{ 0 }; LODIndex < Part->GetLODNum(); ++LODIndex)
+		{
+			const auto* LODInfo{ Part->GetLODInfo(LODIndex) };
+
+			if (!LODInfo || !LODInfo->bAllowCPUAccess)
+			{
+				UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Failed to merge parts, LOD %d of %s does not allow CPU access"), LODIndex, *GetNameSafe(Part));
+
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+USkeletalMesh* UCharacterMergedMeshCache::MergeMesh(TConstArrayView<USkeletalMesh*> Parts, USkeleton* Skeleton)
+{
+	auto* MergedMesh{ NewObject<USkeletalMesh>(this, NAME_None, RF_Transient) };
+	MergedMesh->SetSkeleton(Skeleton);
+
+#if WITH_EDITOR
+	const auto DerivedDataKey{ GetDerivedDataKey(Parts, Skeleton) };
+
+	if (!DerivedDataKey.IsEmpty() && LoadFromDerivedDataCache(DerivedDataKey, MergedMesh))
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("Loaded %d merged parts from the derived data cache (%s)"), Parts.Num(), *GetNameSafe(MergedMesh));
+
+		return MergedMesh;
+	}
+#endif
+
+	const TArray<USkeletalMesh*> SourceMeshes(Parts.GetData(), Parts.Num());
+	const TArray<FSkelMeshMergeSectionMapping> SectionMappings;
+
+	FSkeletalMeshMerge Merger{ MergedMesh, SourceMeshes, SectionMappings, 0 };
+
+	if (!Merger.DoMerge())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Error, TEXT("Failed to merge %d parts into a SkeletalMesh (Skeleton: %s)"), Parts.Num(), *GetNameSafe(Skeleton));
+
+		return nullptr;
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("Merged %d parts into a SkeletalMesh (%s)"), Parts.Num(), *GetNameSafe(MergedMesh));
+
+#if WITH_EDITOR
+	if (!DerivedDataKey.IsEmpty())
+	{
+		SaveToDerivedDataCache(DerivedDataKey, MergedMesh);
+	}
+#endif
+
+	return MergedMesh;
+}
+
+
+#pragma region Derived Data Cache
+
+#if WITH_EDITOR
+// Change when the serialized format of the merged mesh changes to invalidate the stored data
+
+#define GCEXT_MERGEDMESH_DERIVEDDATA_VER TEXT("A5C76D7CFC5F469FA04F941A0DFF795F")
+
+FString UCharacterMergedMeshCache::GetDerivedDataKey(TConstArrayView<USkeletalMesh*> Parts, const USkeleton* Skeleton)
+{
+	if (!GCharacterMergedMeshDerivedDataCache || !Skeleton)
+	{
+		return FString();
+	}
+
+	TStringBuilder<512> KeySuffix;
+	KeySuffix << Skeleton->GetPathName() << TEXT("_") << Skeleton->GetGuid().ToString();
+
+	for (const auto* Part : Parts)
+	{
+		const auto* ImportedModel{ Part ? Part->GetImportedModel() : nullptr };
+
+		if (!ImportedModel)
+		{
+			return FString();
+		}
+
+		KeySuffix << TEXT("_") << Part->GetPathName() << TEXT("_") << ImportedModel->GetIdString();
+	}
+
+	// The path names can be long, so the suffix is hashed to keep the key within the limit of the cache
+
+	const auto SuffixHash{ FSHA1::HashBuffer(KeySuffix.GetData(), KeySuffix.Len() * sizeof(TCHAR)).ToString() };
+
+	return FDerivedDataCacheInterface::BuildCacheKey(TEXT("GCEXT_MERGEDMESH"), GCEXT_MERGEDMESH_DERIVEDDATA_VER, *SuffixHash);
+}
+
+bool UCharacterMergedMeshCache::LoadFromDerivedDataCache(const FString& DerivedDataKey, USkeletalMesh* MergedMesh)
+{
+	TArray<uint8> DerivedData;
+
+	if (!GetDerivedDataCacheRef().GetSynchronous(*DerivedDataKey, DerivedData, MergedMesh->GetPathName()))
+	{
+		return false;
+	}
+
+	FMemoryReader MemoryReader{ DerivedData, true };
+	FObjectAndNameAsStringProxyArchive Ar{ MemoryReader, true };
+
+	SerializeMergedMesh(Ar, MergedMesh);
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("Failed to read merged mesh from the derived data cache, the parts are merged again"));
+
+		MergedMesh->ReleaseResources();
+		return false;
+	}
+
+	return true;
+}
+
+void UCharacterMergedMeshCache::SaveToDerivedDataCache(const FString& DerivedDataKey, USkeletalMesh* MergedMesh)
+{
+	TArray<uint8> DerivedData;
+
+	FMemoryWriter MemoryWriter{ DerivedData, true };
+	FObjectAndNameAsStringProxyArchive Ar{ MemoryWriter, false };
+
+	SerializeMergedMesh(Ar, MergedMesh);
+
+	GetDerivedDataCacheRef().Put(*DerivedDataKey, DerivedData, MergedMesh->GetPathName());
+}
+
+void UCharacterMergedMeshCache::SerializeMergedMesh(FArchive& Ar, USkeletalMesh* MergedMesh)
+{
+	auto RefSkeleton{ MergedMesh->GetRefSkeleton() };
+	auto Materials{ MergedMesh->GetMaterials() };
+	auto ImportedBounds{ MergedMesh->GetImportedBounds() };
+	auto NumLODs{ MergedMesh->GetLODNum() };
+
+	Ar << RefSkeleton;
+	Ar << Materials;
+	Ar << ImportedBounds;
+	Ar << NumLODs;
+
+	if (Ar.IsLoading())
+	{
+		MergedMesh->ResetLODInfo();
+	}
+
+	for (auto LODIndex{ 0 }; LODIndex < NumLODs; ++LODIndex)
+	{
+		auto* LODInfo{ Ar.IsLoading() ? &MergedMesh->AddLODInfo() : MergedMesh->GetLODInfo(LODIndex) };
+
+		Ar << LODInfo->ScreenSize.Default;
+		Ar << LODInfo->LODHysteresis;
+		Ar << LODInfo->LODMaterialMap;
+	}
+
+	// Materials and the reference skeleton must be set before the render data is read
+
+	if (Ar.IsLoading())
+	{
+		MergedMesh->SetRefSkeleton(RefSkeleton);
+		MergedMesh->SetMaterials(Materials);
+		MergedMesh->SetImportedBounds(ImportedBounds);
+		MergedMesh->CalculateInvRefMatrices();
+		MergedMesh->AllocateResourceForRendering();
+	}
+
+	MergedMesh->GetResourceForRendering()->Serialize(Ar, MergedMesh);
+
+	if (Ar.IsLoading() && !Ar.IsError())
+	{
+		MergedMesh->InitResources();
+	}
+}
+
+#undef GCEXT_MERGEDMESH_DERIVEDDATA_VER
+#endif
+
+#pragma endregion
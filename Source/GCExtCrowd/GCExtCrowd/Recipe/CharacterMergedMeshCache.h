@@ -0,0 +1,144 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipeCacheSubsystem.h"
+
+#include "CharacterMergedMeshCache.generated.h"
+
+class USkeletalMesh;
+class USkeleton;
+class FArchive;
+
+
+/**
+ * SkeletalMesh merged from a list of parts
+ */
+USTRUCT()
+struct FCharacterMergedMeshCacheEntry
+{
+	GENERATED_BODY()
+public:
+	FCharacterMergedMeshCacheEntry() {}
+
+public:
+	//
+	// Parts of the merged mesh in the order of merging
+	//
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USkeletalMesh>> Parts;
+
+	//
+	// Skeleton of the merged mesh
+	//
+	UPROPERTY(Transient)
+	TObjectPtr<USkeleton> Skeleton{ nullptr };
+
+	//
+	// Merged mesh
+	//
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMesh> MergedMesh{ nullptr };
+
+};
+
+
+/**
+ * World subsystem that holds SkeletalMeshes merged from modular parts keyed by the part list
+ *
+ * Tips:
+ *	Pawns with the same parts share one merged mesh, so the merge cost is paid once per unique combination.
+ *	The maximum number of merged meshes kept can be changed with "gcext.Recipe.MergedMeshCacheMaxEntries".
+ *	In the editor, merged meshes are also stored in the derived data cache, so that they are not merged again
+ *	in later PIE sessions or editor runs until one of the parts is reimported.
+ *	This can be disabled with "gcext.Recipe.MergedMeshDerivedDataCache 0".
+ *
+ * Note:
+ *	FSkeletalMeshMerge reads the render data of the parts on the CPU.
+ *	In cooked builds, every LOD of the parts must have "Allow CPU Access" enabled, otherwise the parts are not merged.
+ */
+UCLASS()
+class GCEXTCROWD_API UCharacterMergedMeshCache : public UCharacterRecipeCacheSubsystem
+{
+	GENERATED_BODY()
+public:
+	UCharacterMergedMeshCache() {}
+
+	virtual void ClearCache() override;
+	virtual int32 GetNumCachedEntries() const override { return MergedMeshes.Num(); }
+
+protected:
+	//
+	// Mapping list of the hash of the part list and the merged mesh
+	//
+	UPROPERTY(Transient)
+	TMap<uint32, FCharacterMergedMeshCacheEntry> MergedMeshes;
+
+	//
+	// Cache keys in the order of addition, used to remove the oldest merged mesh
+	//
+	FCharacterRecipeCacheKeyOrder MergedMeshKeys;
+
+public:
+	/**
+	 * Returns the mesh merged from the parts, merging them if not cached
+	 *
+	 * Tips:
+	 *	If Skeleton is not specified, the skeleton of the first part is used.
+	 *	Returns nullptr if the merge fails.
+	 */
+	USkeletalMesh* FindOrMergeMesh(TConstArrayView<USkeletalMesh*> Parts, USkeleton* Skeleton);
+
+protected:
+	/**
+	 * Returns hash of the part list
+	 */
+	static uint32 CalculateKey(TConstArrayView<USkeletalMesh*> Parts, const USkeleton* Skeleton);
+
+	/**
+	 * Returns whether the render data of the parts can be read for merging
+	 *
+	 * Tips:
+	 *	Always true in uncooked builds since the source data of the meshes is available.
+	 */
+	static bool CanMergeParts(TConstArrayView<USkeletalMesh*> Parts);
+
+	/**
+	 * Create a new mesh merged from the parts
+	 */
+	USkeletalMesh* MergeMesh(TConstArrayView<USkeletalMesh*> Parts, USkeleton* Skeleton);
+
+
+	/////////////////////////////////////////////////////////////////
+	// Derived Data Cache
+#if WITH_EDITOR
+protected:
+	/**
+	 * Returns key of the merged mesh in the derived data cache
+	 *
+	 * Tips:
+	 *	The key changes when the source model of a part or the skeleton changes.
+	 *	Returns empty if the derived data cache is disabled or a part has no source model.
+	 */
+	static FString GetDerivedDataKey(TConstArrayView<USkeletalMesh*> Parts, const USkeleton* Skeleton);
+
+	/**
+	 * Load the merged mesh of the key from the derived data cache
+	 *
+	 * Tips:
+	 *	Returns false if the key is not cached or the cached data cannot be read.
+	 */
+	static bool LoadFromDerivedDataCache(const FString& DerivedDataKey, USkeletalMesh* MergedMesh);
+
+	/**
+	 * Store the merged mesh in the derived data cache with the key
+	 */
+	static void SaveToDerivedDataCache(const FString& DerivedDataKey, USkeletalMesh* MergedMesh);
+
+	/**
+	 * Serialize the reference skeleton, materials, LOD settings and render data of the merged mesh
+	 */
+	static void SerializeMergedMesh(FArchive& Ar, USkeletalMesh* MergedMesh);
+#endif
+
+};
@@ -0,0 +1,182 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipe_AnimationSharing.h"
+
+#include "Recipe/CharacterSetMeshTypes.h"
+#include "CharacterInitStateComponent.h"
+#include "GCExtLogs.h"
+
+#include "AnimationSharingManager.h"
+#include "AnimationSharingSetup.h"
+#include "GameFramework/Pawn.h"
+#include "Animation/Skeleton.h"
+#include "Engine/AssetManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe_AnimationSharing)
+
+
+UCharacterRecipe_AnimationSharing::UCharacterRecipe_AnimationSharing()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::Instanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ClientOnly;
+	bAllowInstancePooling = true;
+
+#if WITH_EDITOR
+	StaticClass()->FindPropertyByName(FName{ TEXTVIEW("InstancingPolicy") })->SetPropertyFlags(CPF_DisableEditOnTemplate);
+#endif
+}
+
+
+void UCharacterRecipe_AnimationSharing::StartSetup_Implementation(const FCharacterRecipePawnInfo& Info)
+{
+	auto* Pawn{ Info.Pawn.Get() };
+
+	if (!UAnimationSharingManager::AnimationSharingEnabled())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Animation Sharing skipped, sharing is disabled (%s)"), *GetNameSafe(Pawn));
+
+		FinishSetup();
+		return;
+	}
+
+	if (!Pawn || !Info.InitStateComponent.IsValid())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("+Animation Sharing skipped, no CharacterInitStateComponent (%s)"), *GetNameSafe(Pawn));
+
+		FinishSetup();
+		return;
+	}
+
+	// Load the setup only if the manager of the world has not been created yet
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+
+	if (!UAnimationSharingManager::GetAnimationSharingManager(Pawn) && !SharingSetup.IsNull() && !SharingSetup.IsValid())
+	{
+		AssetsToLoad.Emplace(SharingSetup.ToSoftObjectPath());
+	}
+
+	if (!SharingSkeleton.IsNull() && !SharingSkeleton.IsValid())
+	{
+		AssetsToLoad.Emplace(SharingSkeleton.ToSoftObjectPath());
+	}
+
+	if (AssetsToLoad.IsEmpty())
+	{
+		RegisterWithManager();
+		return;
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Request Async Load of Animation Sharing assets (%s)"), *GetNameSafe(Pawn));
+
+	// Bound weakly, so the callback is dropped if this instance is destroyed during loading
+
+	StreamingHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		AssetsToLoad, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleAssetsLoaded));
+
+	if (!StreamingHandle.IsValid())
+	{
+		RegisterWithManager();
+	}
+}
+
+void UCharacterRecipe_AnimationSharing::HandleAssetsLoaded()
+{
+	// The manager holds the setup and the meshes hold the skeleton from now on
+
+	if (StreamingHandle.IsValid())
+	{
+		StreamingHandle->ReleaseHandle();
+		StreamingHandle.Reset();
+	}
+
+	// Skip pawns destroyed during loading
+
+	if (PawnInfo.Pawn.IsValid() && PawnInfo.InitStateComponent.IsValid())
+	{
+		RegisterWithManager();
+	}
+}
+
+void UCharacterRecipe_AnimationSharing::RegisterWithManager()
+{
+	auto* Pawn{ PawnInfo.Pawn.Get() };
+	auto* InitStateComponent{ PawnInfo.InitStateComponent.Get() };
+
+	// Create the manager of the world with the setup on first use
+
+	auto* Manager{ UAnimationSharingManager::GetAnimationSharingManager(Pawn) };
+
+	if (!Manager && SharingSetup.IsValid())
+	{
+		UAnimationSharingManager::CreateAnimationSharingManager(Pawn, SharingSetup.Get());
+
+		Manager = UAnimationSharingManager::GetAnimationSharingManager(Pawn);
+	}
+
+	auto* Skeleton{ SharingSkeleton.Get() };
+
+	if (!Manager || !Skeleton)
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("+Animation Sharing skipped, no manager or skeleton (%s)"), *GetNameSafe(Pawn));
+
+		FinishSetup();
+		return;
+	}
+
+	// Remove the AnimInstances in the same commit as the staged changes of the preceding CharacterRecipes so that they are never created.
+	// This CharacterRecipe starts with those changes still staged, and commits them itself since the manager registers the final meshes.
+
+	for (const auto& MeshTag : MeshTags)
+	{
+		FMeshToSetMesh MeshToSet;
+		MeshToSet.MeshTag = MeshTag;
+		MeshToSet.bShouldChangeAnimInstance = true;
+		MeshToSet.AnimInstance = nullptr;
+
+		InitStateComponent->StageMeshChanges(MakeArrayView(&MeshToSet, 1));
+	}
+
+	InitStateComponent->CommitStagedMeshChanges();
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Register Animation Sharing (Pawn: %s, Skeleton: %s)"), *GetNameSafe(Pawn), *GetNameSafe(Skeleton));
+
+	Manager->RegisterActorWithSkeletonBP(Pawn, Skeleton);
+
+	bRegistered = true;
+
+	FinishSetup();
+}
+
+void UCharacterRecipe_AnimationSharing::CancelStreaming()
+{
+	if (StreamingHandle.IsValid())
+	{
+		StreamingHandle->CancelHandle();
+		StreamingHandle.Reset();
+	}
+}
+
+void UCharacterRecipe_AnimationSharing::OnDestroy_Implementation()
+{
+	CancelStreaming();
+
+	if (bRegistered)
+	{
+		auto* Pawn{ PawnInfo.Pawn.Get() };
+
+		if (auto* Manager{ Pawn ? UAnimationSharingManager::GetAnimationSharingManager(Pawn) : nullptr })
+		{
+			Manager->UnregisterActor(Pawn);
+		}
+
+		bRegistered = false;
+	}
+}
+
+void UCharacterRecipe_AnimationSharing::ResetForPool_Implementation()
+{
+	CancelStreaming();
+
+	bRegistered = false;
+}
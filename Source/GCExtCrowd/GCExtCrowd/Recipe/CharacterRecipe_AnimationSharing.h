@@ -0,0 +1,86 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipe.h"
+
+#include "Engine/StreamableManager.h"
+
+#include "CharacterRecipe_AnimationSharing.generated.h"
+
+class UAnimationSharingSetup;
+class USkeleton;
+
+
+/**
+ * Recipe class to register the meshes of the pawn with the AnimationSharing plugin
+ *
+ * Tips:
+ *	Instead of each pawn evaluating its own AnimInstance, the meshes follow a pose evaluated once per state
+ *	and shared by all registered actors. Intended for crowd NPCs that do not need individual animation.
+ *
+ *	The AnimInstances of the meshes of MeshTags are removed so that AnimInstances set by other CharacterRecipes
+ *	are not created. Add those CharacterRecipes to PrerequisiteRecipeClasses.
+ *	If AnimationSharing is disabled (a.Sharing.Enabled 0), the meshes keep their own AnimInstances.
+ *	SharingSetup and SharingSkeleton are loaded asynchronously if they are not resident yet.
+ */
+UCLASS()
+class UCharacterRecipe_AnimationSharing final : public UCharacterRecipe
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_AnimationSharing();
+
+protected:
+	//
+	// Setup used to create the AnimationSharingManager of the world if it has not been created yet
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation Sharing")
+	TSoftObjectPtr<UAnimationSharingSetup> SharingSetup;
+
+	//
+	// Skeleton registered in SharingSetup that the meshes of the pawn use
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation Sharing")
+	TSoftObjectPtr<USkeleton> SharingSkeleton;
+
+	//
+	// Tags of the meshes whose AnimInstances are replaced by the shared animation
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Animation Sharing", meta = (Categories = "MeshType"))
+	TArray<FGameplayTag> MeshTags;
+
+	//
+	// Whether the pawn is registered with the AnimationSharingManager
+	//
+	bool bRegistered{ false };
+
+	//
+	// Streamable handle of SharingSetup and SharingSkeleton while they are loading
+	//
+	TSharedPtr<FStreamableHandle> StreamingHandle;
+
+public:
+	virtual bool CanStartWithStagedMeshChanges() const override { return true; }
+
+protected:
+	virtual void StartSetup_Implementation(const FCharacterRecipePawnInfo& Info) override;
+	virtual void OnDestroy_Implementation() override;
+	virtual void ResetForPool_Implementation() override;
+
+	/**
+	 * Register the pawn with the AnimationSharingManager after SharingSetup and SharingSkeleton are loaded
+	 */
+	void RegisterWithManager();
+
+	/**
+	 * Executed when SharingSetup and SharingSkeleton have arrived
+	 */
+	void HandleAssetsLoaded();
+
+	/**
+	 * Cancel the load of SharingSetup and SharingSkeleton in flight
+	 */
+	void CancelStreaming();
+
+};
@@ -0,0 +1,97 @@
+﻿// Copyright (C) 2024 owoDra
+
+#include "CharacterRecipe_MergeMesh.h"
+
+#include "Recipe/CharacterMergedMeshCache.h"
+#include "Recipe/CharacterSetMeshTypes.h"
+#include "CharacterInitStateComponent.h"
+#include "GCExtLogs.h"
+
+#include "GameFramework/Pawn.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Animation/Skeleton.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(CharacterRecipe_MergeMesh)
+
+
+UCharacterRecipe_MergeMesh::UCharacterRecipe_MergeMesh()
+{
+	InstancingPolicy = ECharacterRecipeInstancingPolicy::NonInstanced;
+	NetExecutionPolicy = ECharacterRecipeNetExecutionPolicy::ClientOnly;
+
+#if WITH_EDITOR
+	StaticClass()->FindPropertyByName(FName{ TEXTVIEW("InstancingPolicy") })->SetPropertyFlags(CPF_DisableEditOnTemplate);
+#endif
+}
+
+
+void UCharacterRecipe_MergeMesh::StartSetupNonInstanced_Implementation(FCharacterRecipePawnInfo Info) const
+{
+	auto* InitStateComponent{ Info.InitStateComponent.Get() };
+
+	if (!InitStateComponent)
+	{
+		return;
+	}
+
+	TArray<USkeletalMesh*, TInlineAllocator<16>> Parts;
+	TArray<USkeletalMeshComponent*, TInlineAllocator<16>> PartComponents;
+
+	for (const auto& PartMeshTag : PartMeshTags)
+	{
+		if (auto* PartComponent{ InitStateComponent->GetMeshByTag(PartMeshTag) })
+		{
+			if (auto* PartMesh{ PartComponent->GetSkeletalMeshAsset() })
+			{
+				Parts.Emplace(PartMesh);
+				PartComponents.Emplace(PartComponent);
+			}
+		}
+	}
+
+	if (Parts.IsEmpty())
+	{
+		UE_LOG(LogGameExt_CharacterRecipe, Warning, TEXT("+Merge Mesh skipped, no parts have a mesh (%s)"), *GetNameSafe(this));
+		return;
+	}
+
+	auto* MergedMeshCache{ UWorld::GetSubsystem<UCharacterMergedMeshCache>(Info.Pawn->GetWorld()) };
+
+	if (!MergedMeshCache)
+	{
+		return;
+	}
+
+	auto* MergedMesh{ MergedMeshCache->FindOrMergeMesh(Parts, Skeleton.IsNull() ? nullptr : Skeleton.LoadSynchronous()) };
+
+	if (!MergedMesh)
+	{
+		return;
+	}
+
+	UE_LOG(LogGameExt_CharacterRecipe, Log, TEXT("+Merge Mesh (Parts: %d, Mesh: %s)"), Parts.Num(), *GetNameSafe(MergedMesh));
+
+	// Set the merged mesh with the other mesh changes
+
+	FMeshToSetMesh MeshToSet;
+	MeshToSet.MeshTag = TargetMeshTag;
+	MeshToSet.bShouldChangeMesh = true;
+	MeshToSet.SkeletalMesh = MergedMesh;
+
+	InitStateComponent->StageMeshChanges(MakeArrayView(&MeshToSet, 1));
+
+	if (bHidePartComponents)
+	{
+		auto* TargetComponent{ InitStateComponent->GetMeshByTag(TargetMeshTag) };
+
+		for (auto* PartComponent : PartComponents)
+		{
+			if (PartComponent != TargetComponent)
+			{
+				PartComponent->SetVisibility(false);
+				PartComponent->SetComponentTickEnabled(false);
+			}
+		}
+	}
+}
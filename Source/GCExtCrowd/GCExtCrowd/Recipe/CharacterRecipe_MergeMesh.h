@@ -0,0 +1,68 @@
+﻿// Copyright (C) 2024 owoDra
+
+#pragma once
+
+#include "Recipe/CharacterRecipe.h"
+
+#include "CharacterRecipe_MergeMesh.generated.h"
+
+class USkeleton;
+
+
+/**
+ * Recipe class to merge the meshes of modular part components into one SkeletalMesh
+ *
+ * Tips:
+ *	The meshes currently set on the part components are merged and set on the target component,
+ *	and the part components are hidden so that the character is drawn by one component.
+ *	Merged meshes are shared through CharacterMergedMeshCache by pawns with the same parts.
+ *
+ *	Add the CharacterRecipes that set the meshes of the parts to PrerequisiteRecipeClasses,
+ *	so that the parts are final when they are merged.
+ */
+UCLASS()
+class UCharacterRecipe_MergeMesh final : public UCharacterRecipe
+{
+	GENERATED_BODY()
+public:
+	UCharacterRecipe_MergeMesh();
+
+protected:
+	//
+	// Tag of the mesh to set the merged mesh
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Merge Mesh", meta = (Categories = "MeshType"))
+	FGameplayTag TargetMeshTag;
+
+	//
+	// Tags of the meshes to be merged in the order of merging
+	//
+	// Tips:
+	//	Parts without a mesh are skipped.
+	//
+	// Note:
+	//	In cooked builds, every LOD of the part meshes must have "Allow CPU Access" enabled,
+	//	since the merge reads their render data on the CPU. Otherwise the parts are not merged and keep their own components.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Merge Mesh", meta = (Categories = "MeshType"))
+	TArray<FGameplayTag> PartMeshTags;
+
+	//
+	// Skeleton of the merged mesh
+	//
+	// Tips:
+	//	If not set, the skeleton of the first part is used.
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Merge Mesh")
+	TSoftObjectPtr<USkeleton> Skeleton;
+
+	//
+	// Whether to hide the part components other than the target after merging
+	//
+	UPROPERTY(EditDefaultsOnly, Category = "Merge Mesh")
+	bool bHidePartComponents{ true };
+
+protected:
+	virtual void StartSetupNonInstanced_Implementation(FCharacterRecipePawnInfo Info) const override;
+
+};
@@ -28,7 +28,7 @@ public class GECharacterEditor : ModuleRules
 			{
                 "Core", "CoreUObject", "Engine", "UnrealEd",
 
-                "ClassViewer", "AssetTools", "ToolMenus",
+                "ClassViewer", "AssetTools", "AssetRegistry", "ToolMenus",
 
                 "InputCore", "Slate", "SlateCore",
 
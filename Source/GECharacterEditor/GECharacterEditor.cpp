@@ -5,16 +5,24 @@
 #include "AssetTypeActions/AssetTypeActions_CharacterRecipeBlueprint.h"
 #include "AssetTypeActions/AssetTypeActions_CharacterSet.h"
 
+#include "Recipe/CharacterRecipeBlueprint.h"
+#include "Recipe/CharacterRecipeRegistry.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Containers/Ticker.h"
+
 IMPLEMENT_MODULE(FGECharacterEditorModule, GECharacterEditor)
 
 
 void FGECharacterEditorModule::StartupModule()
 {
 	RegisterAssetTypeActions();
+	RegisterRecipeRegistryUpdater();
 }
 
 void FGECharacterEditorModule::ShutdownModule()
 {
+	UnregisterRecipeRegistryUpdater();
 	UnregisterAssetTypeActions();
 }
 
@@ -57,3 +65,84 @@ void FGECharacterEditorModule::UnregisterAssets(TArray<TSharedPtr<FAssetTypeActi
 		}
 	}
 }
+
+
+void FGECharacterEditorModule::RegisterRecipeRegistryUpdater()
+{
+	auto& AssetRegistry{ FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get() };
+
+	AssetRegistry.OnAssetAdded().AddRaw(this, &FGECharacterEditorModule::HandleRecipeAssetAddedOrRemoved);
+	AssetRegistry.OnAssetRemoved().AddRaw(this, &FGECharacterEditorModule::HandleRecipeAssetAddedOrRemoved);
+	AssetRegistry.OnAssetRenamed().AddRaw(this, &FGECharacterEditorModule::HandleRecipeAssetRenamed);
+
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		AssetRegistry.OnFilesLoaded().AddRaw(this, &FGECharacterEditorModule::UpdateRecipeRegistry);
+	}
+	else
+	{
+		UpdateRecipeRegistry();
+	}
+}
+
+void FGECharacterEditorModule::UnregisterRecipeRegistryUpdater()
+{
+	if (RecipeRegistryUpdateTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(RecipeRegistryUpdateTickerHandle);
+		RecipeRegistryUpdateTickerHandle.Reset();
+	}
+
+	if (auto* AssetRegistryModule{ FModuleManager::GetModulePtr<FAssetRegistryModule>(AssetRegistryConstants::ModuleName) })
+	{
+		auto& AssetRegistry{ AssetRegistryModule->Get() };
+
+		AssetRegistry.OnAssetAdded().RemoveAll(this);
+		AssetRegistry.OnAssetRemoved().RemoveAll(this);
+		AssetRegistry.OnAssetRenamed().RemoveAll(this);
+		AssetRegistry.OnFilesLoaded().RemoveAll(this);
+	}
+}
+
+void FGECharacterEditorModule::HandleRecipeAssetAddedOrRemoved(const FAssetData& AssetData)
+{
+	if (AssetData.AssetClassPath == UCharacterRecipeBlueprint::StaticClass()->GetClassPathName())
+	{
+		RequestUpdateRecipeRegistry();
+	}
+}
+
+void FGECharacterEditorModule::HandleRecipeAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+	HandleRecipeAssetAddedOrRemoved(AssetData);
+}
+
+void FGECharacterEditorModule::RequestUpdateRecipeRegistry()
+{
+	// Ignore changes during the initial scan, it is rebuilt once all files are loaded
+
+	const auto& AssetRegistry{ FModuleManager::LoadModuleChecked<FAssetRegistryModule>(AssetRegistryConstants::ModuleName).Get() };
+
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		return;
+	}
+
+	// Collect multiple changes in the same frame into one update
+
+	if (!RecipeRegistryUpdateTickerHandle.IsValid())
+	{
+		RecipeRegistryUpdateTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+			[this](float DeltaTime)
+			{
+				RecipeRegistryUpdateTickerHandle.Reset();
+				UpdateRecipeRegistry();
+				return false;
+			}));
+	}
+}
+
+void FGECharacterEditorModule::UpdateRecipeRegistry()
+{
+	GetMutableDefault<UCharacterRecipeRegistry>()->RebuildRegistry();
+}
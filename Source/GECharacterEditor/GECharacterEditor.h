@@ -7,6 +7,9 @@
 #include "AssetTypeCategories.h"
 #include "AssetTypeActions_Base.h"
 #include "IAssetTools.h"
+#include "Containers/Ticker.h"
+
+struct FAssetData;
 
 
 /**
@@ -61,6 +64,40 @@ protected:
 	}
 
 	void UnregisterAssets(TArray<TSharedPtr<FAssetTypeActions_Base>>& RegisteredAssets);
+
+
+protected:
+	//
+	// Handle of the ticker waiting to update CharacterRecipeRegistry
+	//
+	FTSTicker::FDelegateHandle RecipeRegistryUpdateTickerHandle;
+
+protected:
+	/**
+	 * Start rebuilding CharacterRecipeRegistry when CharacterRecipe classes are added or removed
+	 * 
+	 * Tips:
+	 *	The registry is only rebuilt in memory and is not saved to config
+	 */
+	void RegisterRecipeRegistryUpdater();
+
+	/**
+	 * Stop rebuilding CharacterRecipeRegistry
+	 */
+	void UnregisterRecipeRegistryUpdater();
+
+	void HandleRecipeAssetAddedOrRemoved(const FAssetData& AssetData);
+	void HandleRecipeAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+
+	/**
+	 * Rebuild CharacterRecipeRegistry in the next tick
+	 */
+	void RequestUpdateRecipeRegistry();
+
+	/**
+	 * Rebuild CharacterRecipeRegistry from the AssetRegistry
+	 */
+	void UpdateRecipeRegistry();
 };
 
 
@@ -4,8 +4,14 @@
 
 #include "CharacterInitStateComponent.h"
 #include "CharacterSet.h"
+#include "CharacterBakedBuild.h"
 #include "GECharacterEditor.h"
 
+#include "ToolMenuSection.h"
+#include "ScopedTransaction.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+
 
 #pragma region AssetTypeAction
 
@@ -29,4 +35,67 @@ UClass* FAssetTypeActions_CharacterSet::GetSupportedClass() const
 	return UCharacterSet::StaticClass();
 }
 
+
+void FAssetTypeActions_CharacterSet::GetActions(const TArray<UObject*>& InObjects, FToolMenuSection& Section)
+{
+	// Baked builds cannot be baked again
+
+	TArray<TWeakObjectPtr<UCharacterSet>> CharacterSets;
+
+	for (auto* Object : InObjects)
+	{
+		if (auto* CharacterSet{ Cast<UCharacterSet>(Object) }; CharacterSet && !CharacterSet->IsA<UCharacterBakedBuild>())
+		{
+			CharacterSets.Emplace(CharacterSet);
+		}
+	}
+
+	if (CharacterSets.IsEmpty())
+	{
+		return;
+	}
+
+	Section.AddMenuEntry(
+		"CharacterSet_BakeCharacterBuild",
+		NSLOCTEXT("AssetTypeActions", "CharacterSet_BakeCharacterBuild", "Bake Character Build"),
+		NSLOCTEXT("AssetTypeActions", "CharacterSet_BakeCharacterBuildTooltip", "Bakes the deterministic CharacterRecipes of the CharacterSet into a CharacterBakedBuild asset that is applied without creating CharacterRecipe objects."),
+		FSlateIcon(),
+		FUIAction(FExecuteAction::CreateSP(this, &FAssetTypeActions_CharacterSet::ExecuteBakeCharacterBuild, MoveTemp(CharacterSets)))
+	);
+}
+
+void FAssetTypeActions_CharacterSet::ExecuteBakeCharacterBuild(TArray<TWeakObjectPtr<UCharacterSet>> CharacterSets)
+{
+	const FScopedTransaction Transaction(NSLOCTEXT("AssetTypeActions", "CharacterSet_BakeCharacterBuildTransaction", "Bake Character Build"));
+
+	for (const auto& WeakCharacterSet : CharacterSets)
+	{
+		auto* CharacterSet{ WeakCharacterSet.Get() };
+
+		if (!CharacterSet)
+		{
+			continue;
+		}
+
+		const auto AssetName{ CharacterSet->GetName() + TEXT("_Baked") };
+		const auto PackageName{ FPackageName::GetLongPackagePath(CharacterSet->GetOutermost()->GetName()) / AssetName };
+
+		// Rebuild the existing baked build so that references to it are kept
+
+		auto* BakedBuild{ LoadObject<UCharacterBakedBuild>(nullptr, *(PackageName + TEXT(".") + AssetName), nullptr, LOAD_NoWarn | LOAD_Quiet) };
+
+		if (!BakedBuild)
+		{
+			auto* Package{ CreatePackage(*PackageName) };
+
+			BakedBuild = NewObject<UCharacterBakedBuild>(Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+
+			FAssetRegistryModule::AssetCreated(BakedBuild);
+		}
+
+		BakedBuild->BakeFromCharacterSet(CharacterSet);
+		BakedBuild->MarkPackageDirty();
+	}
+}
+
 #pragma endregion
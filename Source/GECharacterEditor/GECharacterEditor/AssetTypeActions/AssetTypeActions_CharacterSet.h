@@ -21,4 +21,16 @@ public:
 	virtual uint32 GetCategories() override;
 	virtual UClass* GetSupportedClass() const override;
 
+	virtual bool HasActions(const TArray<UObject*>& InObjects) const override { return true; }
+	virtual void GetActions(const TArray<UObject*>& InObjects, FToolMenuSection& Section) override;
+
+protected:
+	/**
+	 * Bake the deterministic CharacterRecipes of each CharacterSet into a CharacterBakedBuild asset next to it
+	 * 
+	 * Tips:
+	 *	If the CharacterBakedBuild asset already exists, it is rebuilt in place.
+	 */
+	void ExecuteBakeCharacterBuild(TArray<TWeakObjectPtr<UCharacterSet>> CharacterSets);
+
 };